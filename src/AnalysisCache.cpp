@@ -0,0 +1,358 @@
+//==============================================================================
+// AnalysisCache.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "AnalysisCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "MappedFile.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+char const magic[4] = { 'G', 'A', 'C', 'H' };
+unsigned const version = 1;
+unsigned const headerSize = 16;
+unsigned const recordSize = 16;
+
+// stores beyond this many waiting for the writer are dropped
+unsigned const maxPending = 1 << 16;
+
+//------------------------------------------------------------------------------
+// Data word layout as in TranspositionTable: score in bits 0-15, move in 16-31,
+// depth in 32-39, bound in 40-47. The checksum takes bits 48-63.
+unsigned long long const payload = 0xffffffffffffull;
+
+inline unsigned long long checksum (HashKey key, unsigned long long data) {
+   unsigned long long h = (key ^ (data & payload)) * 0x9e3779b97f4a7c15ull;
+   h ^= h >> 29;
+   h *= 0xbf58476d1ce4e5b9ull;
+   h ^= h >> 32;
+   return h << 48;
+}
+
+inline int depthOf (unsigned long long data) { return (data >> 32) & 0xff; }
+inline unsigned boundOf (unsigned long long data) { return (data >> 40) & 0xff; }
+
+// a record of zeros (ex, a block the file system hadn't written) doesn't check out
+inline bool valid (HashKey key, unsigned long long data) {
+   unsigned bound = boundOf(data);
+   return key != 0 && TTEntry::upper <= bound && bound <= TTEntry::exact
+       && (data & ~payload) == checksum(key, data);
+}
+
+//------------------------------------------------------------------------------
+bool writeAll (int fd, char const* p, unsigned long long n) {
+   while (n) {
+      ssize_t written = ::write(fd, p, n);
+      if (written <= 0)
+         return false;
+      p += written;
+      n -= written;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool writeHeader (int fd) {
+   unsigned header[4] = { 0, version, 0, 0 };
+   memcpy(header, magic, 4);
+   return writeAll(fd, reinterpret_cast<char const*>(header), headerSize);
+}
+
+}
+
+
+//==============================================================================
+// Analysis Cache
+//==============================================================================
+
+//------------------------------------------------------------------------------
+AnalysisCache::AnalysisCache ():
+   _fd(-1),
+   _slots(0),
+   _mask(0),
+   _count(0),
+   _discarded(0),
+   _minDepth(6),
+   _busy(false),
+   _sync(false),
+   _quit(false),
+   _failed(false)
+{}
+
+//------------------------------------------------------------------------------
+bool AnalysisCache::open (char const* path, unsigned long long capacity) {
+   close();
+   int fd = ::open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+   if (fd < 0)
+      return false;
+
+   struct stat info;
+   MappedFile file;
+   if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+      ::close(fd);
+      return false;
+   }
+   if (info.st_size < static_cast<off_t>(headerSize)) {
+      // new (or cut short before its header was whole)
+      if (ftruncate(fd, 0) != 0 || !writeHeader(fd)) {
+         ::close(fd);
+         return false;
+      }
+   } else {
+      unsigned header[4];
+      if (!file.open(path)) {
+         ::close(fd);
+         return false;
+      }
+      memcpy(header, file.begin(), headerSize);
+      if (memcmp(header, magic, 4) != 0 || header[1] != version) {
+         ::close(fd);
+         return false;
+      }
+   }
+
+   unsigned long long records = file.isOpen() ? (file.size() - headerSize) / recordSize : 0;
+   if (capacity < records)
+      capacity = records;
+   unsigned long long slots = 1024;
+   while (slots < capacity * 2)
+      slots <<= 1;
+   _slots = new Slot[slots];
+   _mask = slots - 1;
+   for (unsigned long long i=0; i<slots; ++i) {
+      _slots[i].key.store(0, std::memory_order_relaxed);
+      _slots[i].data.store(0, std::memory_order_relaxed);
+   }
+   _count = 0;
+
+   // the log ends at the first record that doesn't check out
+   unsigned long long good = 0;
+   for ( ; good < records; ++good) {
+      Record r;
+      memcpy(&r, file.begin() + headerSize + good * recordSize, recordSize);
+      if (!valid(r.key, r.data))
+         break;
+      insert(r.key, r.data);
+   }
+   _discarded = file.isOpen() ? file.size() - headerSize - good * recordSize : 0;
+   file.close();
+   if (_discarded && ftruncate(fd, headerSize + good * recordSize) != 0) {
+      ::close(fd);
+      delete[] _slots;
+      _slots = 0;
+      return false;
+   }
+
+   _path = path;
+   _fd = fd;
+   _failed = false;
+   _quit = false;
+   _writer = std::thread(&AnalysisCache::writerLoop, this);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void AnalysisCache::close () {
+   if (!_slots)
+      return;
+   flush();
+   stopWriter();
+   ::close(_fd);
+   _fd = -1;
+   delete[] _slots;
+   _slots = 0;
+   _mask = 0;
+   _count = 0;
+}
+
+//------------------------------------------------------------------------------
+void AnalysisCache::stopWriter () {
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _quit = true;
+   }
+   _wake.notify_all();
+   if (_writer.joinable())
+      _writer.join();
+}
+
+//------------------------------------------------------------------------------
+// The index never gets full, so a probe always meets the key or an empty slot.
+AnalysisCache::Slot const* AnalysisCache::find (HashKey key) const {
+   unsigned long long i = key & _mask;
+   for (;;) {
+      HashKey k = _slots[i].key.load(std::memory_order_acquire);
+      if (k == key || k == 0)
+         return _slots + i;
+      i = (i + 1) & _mask;
+   }
+}
+
+//------------------------------------------------------------------------------
+bool AnalysisCache::probe (HashKey key, TTEntry& entry) const {
+   if (!_slots || key == 0)
+      return false;
+   Slot const* slot = find(key);
+   unsigned long long data = slot->data.load(std::memory_order_relaxed);
+   if (slot->key.load(std::memory_order_relaxed) != key || !data)
+      return false;
+   entry.score = static_cast<short>(data & 0xffff);
+   entry.move  = static_cast<unsigned short>((data >> 16) & 0xffff);
+   entry.depth = static_cast<unsigned char>(depthOf(data));
+   entry.bound = static_cast<unsigned char>(boundOf(data));
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Only the writer thread (or open) inserts. A new slot gets its data before its
+// key, so a reader that sees the key sees the data too.
+bool AnalysisCache::insert (HashKey key, unsigned long long data) {
+   Slot* slot = const_cast<Slot*>(find(key));
+   if (slot->key.load(std::memory_order_relaxed) == key) {
+      if (depthOf(slot->data.load(std::memory_order_relaxed)) > depthOf(data))
+         return false;
+      slot->data.store(data, std::memory_order_relaxed);
+      return true;
+   }
+   if (_count >= (_mask + 1) / 4 * 3)
+      return false;
+   slot->data.store(data, std::memory_order_relaxed);
+   slot->key.store(key, std::memory_order_release);
+   ++_count;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void AnalysisCache::store (HashKey key, int score, Move const& move, int depth, unsigned char bound) {
+   if (!_slots || key == 0 || depth < _minDepth)
+      return;
+   // the writer would drop it anyway
+   TTEntry old;
+   if (probe(key, old) && old.depth > depth)
+      return;
+   unsigned long long data = static_cast<unsigned short>(static_cast<short>(score))
+                           | (static_cast<unsigned long long>(move.pack()) << 16)
+                           | (static_cast<unsigned long long>(depth > 255 ? 255 : depth) << 32)
+                           | (static_cast<unsigned long long>(bound) << 40);
+   Record r = { key, data | checksum(key, data) };
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_pending.size() >= maxPending)
+         return;
+      _pending.push_back(r);
+   }
+   _wake.notify_one();
+}
+
+//------------------------------------------------------------------------------
+bool AnalysisCache::flush () {
+   if (!_slots)
+      return false;
+   std::unique_lock<std::mutex> lock(_mutex);
+   _sync = true;
+   _wake.notify_one();
+   while (_sync || _busy || !_pending.empty())
+      _idle.wait(lock);
+   return !_failed;
+}
+
+//------------------------------------------------------------------------------
+// Results that don't improve on the index are skipped; the rest go to the
+// index and to the log in one write.
+bool AnalysisCache::append (Record const* records, unsigned count) {
+   std::vector<Record> kept;
+   kept.reserve(count);
+   for (unsigned i=0; i<count; ++i) {
+      if (insert(records[i].key, records[i].data))
+         kept.push_back(records[i]);
+   }
+   return kept.empty()
+       || writeAll(_fd, reinterpret_cast<char const*>(&kept[0]), kept.size() * recordSize);
+}
+
+//------------------------------------------------------------------------------
+void AnalysisCache::writerLoop () {
+   std::unique_lock<std::mutex> lock(_mutex);
+   std::vector<Record> batch;
+   for (;;) {
+      while (!_quit && !_sync && _pending.empty())
+         _wake.wait(lock);
+      if (_quit && _pending.empty())
+         break;
+      batch.swap(_pending);
+      bool sync = _sync;
+      _busy = true;
+      lock.unlock();
+
+      bool ok = append(batch.empty() ? 0 : &batch[0], batch.size());
+      if (sync)
+         ok = fdatasync(_fd) == 0 && ok;
+      if (!ok)
+         _failed = true;
+      batch.clear();
+
+      lock.lock();
+      _busy = false;
+      if (sync)
+         _sync = false;
+      _idle.notify_all();
+   }
+}
+
+//------------------------------------------------------------------------------
+// The new file is written beside the old one and renamed over it, so a crash
+// leaves one or the other whole.
+long long AnalysisCache::compact () {
+   if (!flush())
+      return -1;
+   stopWriter();
+
+   std::string temporary = _path + ".compact";
+   int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   bool ok = fd >= 0 && writeHeader(fd);
+   unsigned long long kept = 0;
+   std::vector<Record> buffer;
+   for (unsigned long long i=0; ok && i<=_mask; ++i) {
+      Record r = { _slots[i].key.load(std::memory_order_relaxed),
+                   _slots[i].data.load(std::memory_order_relaxed) };
+      if (r.key) {
+         buffer.push_back(r);
+         ++kept;
+      }
+      if (buffer.size() == 65536 || (i == _mask && !buffer.empty())) {
+         ok = writeAll(fd, reinterpret_cast<char const*>(&buffer[0]), buffer.size() * recordSize);
+         buffer.clear();
+      }
+   }
+   ok = ok && fsync(fd) == 0;
+   if (fd >= 0)
+      ok = ::close(fd) == 0 && ok;
+   ok = ok && std::rename(temporary.c_str(), _path.c_str()) == 0;
+
+   if (ok) {
+      int appendFd = ::open(_path.c_str(), O_WRONLY | O_APPEND);
+      if (appendFd >= 0) {
+         ::close(_fd);
+         _fd = appendFd;
+      } else {
+         ok = false;
+      }
+   } else {
+      std::remove(temporary.c_str());
+   }
+
+   _quit = false;
+   _writer = std::thread(&AnalysisCache::writerLoop, this);
+   return ok ? static_cast<long long>(kept) : -1;
+}
@@ -0,0 +1,116 @@
+//==============================================================================
+// AnalysisCache.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef ANALYSISCACHE
+#define ANALYSISCACHE
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Chess.h"
+#include "Search.h"
+
+
+//==============================================================================
+// Analysis Cache
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Search results that outlive the process, for positions analyzed again and
+// again across sessions.
+/*
+ * The file is a 16 byte header followed by an append only log of 16 byte
+ * records: the position key, then a data word laid out like a transposition
+ * table slot's (score, move, depth, bound) with a checksum of both in its top
+ * 16 bits. Opening maps the file and indexes every record that checks out,
+ * deeper results replacing shallower ones. A crash can only tear the records
+ * appended last, so the first bad record ends the log and the file is cut
+ * back to it.
+ *
+ * Probes are lock free and may come from any search thread. Stores are queued
+ * and a background thread appends them, so searching never waits on the disk.
+ * Since the log keeps every result ever appended, compact() rewrites it with
+ * only the live one per position.
+ *
+ * The index is sized when the file is opened; once three quarters full it
+ * only takes results for positions it already holds.
+ */
+class AnalysisCache {
+private:
+   struct Slot {
+      std::atomic<HashKey> key;
+      std::atomic<unsigned long long> data;
+   };
+   struct Record {
+      HashKey key;
+      unsigned long long data;
+   };
+
+   std::string _path;
+   int _fd;
+   Slot* _slots;
+   unsigned long long _mask;
+   unsigned long long _count;
+   unsigned long long _discarded;
+   int _minDepth;
+
+   // the writer thread's queue
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   std::condition_variable _idle;
+   std::vector<Record> _pending;
+   std::thread _writer;
+   bool _busy;
+   bool _sync;
+   bool _quit;
+   std::atomic<bool> _failed;
+
+   AnalysisCache (AnalysisCache const&);
+   void operator= (AnalysisCache const&);
+
+public:
+   AnalysisCache ();
+   ~AnalysisCache () { close(); }
+
+   // opens the cache, creating it if need be, with room for at least capacity
+   // positions; fails if the file isn't a cache
+   bool open (char const* path, unsigned long long capacity = 1 << 20);
+   // waits for queued results to be written
+   void close ();
+   bool isOpen () const { return _slots != 0; }
+
+   // only results at least this deep are stored (probing is up to the caller)
+   int minDepth () const { return _minDepth; }
+   void setMinDepth (int depth) { _minDepth = depth; }
+
+   bool probe (HashKey key, TTEntry& entry) const;
+   // queues a result (scores as a transposition table stores them); results
+   // no deeper than the one held are dropped
+   void store (HashKey key, int score, Move const& move, int depth, unsigned char bound);
+   // returns once every queued result is written and synced; false if a
+   // write has failed since the cache was opened
+   bool flush ();
+   // rewrites the file with one record per position; returns the number of
+   // records kept, or -1 on failure (leaving the old file in place)
+   long long compact ();
+
+   // positions held
+   unsigned long long size () const { return _count; }
+   // bytes of torn or corrupt records dropped when the file was opened
+   unsigned long long discarded () const { return _discarded; }
+
+private:
+   Slot const* find (HashKey key) const;
+   bool insert (HashKey key, unsigned long long data);
+   bool append (Record const* records, unsigned count);
+   void writerLoop ();
+   void stopWriter ();
+};
+
+
+#endif
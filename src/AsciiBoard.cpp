@@ -4,54 +4,101 @@
 //==============================================================================
 
 #include "AsciiBoard.h"
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "Trace.h"
 
 
+namespace {
+
+//------------------------------------------------------------------------------
+char const ruler[] =
+   "|----------+----------+----------+----------+----------+----------+----------+----------|   \n";
+char const letters[] =
+   "     A          B          C          D          E          F          G          H\n";
+
 //------------------------------------------------------------------------------
-AsciiBoard::AsciiBoard (BitBoard const& b) {
-   negativeSpaceIsDark = true;
-
-   // Draw board itself
-   std::ostringstream out;
-   bool light = true;
-   Square s = 56;
-   out << "|----------+----------+----------+----------+----------+----------+----------+----------|   \n";
-   for (int r = 7; r >= 0; --r) {
-      s = 8 * r;
-      // each rank needs many lines
-      for (int i=0; i<4; ++i) {
-         s = (r << 3) + i;
-         for (int file = 0; file < 8; ++file) {
-            out << '|';
-            if (light == negativeSpaceIsDark) {
-               out << "..........";
-            } else {
-               out << "          ";
+// The empty board for one coloring.
+struct Template {
+   char str[AsciiBoard::size];
+
+   Template (bool negativeSpaceIsDark) {
+      char* out = str;
+      bool light = true;
+      memcpy(out, ruler, AsciiBoard::rowL);
+      out += AsciiBoard::rowL;
+      for (int r = 7; r >= 0; --r) {
+         // each rank needs many lines
+         for (int i=0; i<4; ++i) {
+            for (int file = 0; file < 8; ++file) {
+               *out++ = '|';
+               memset(out, light == negativeSpaceIsDark ? '.' : ' ', 10);
+               out += 10;
+               light = !light;
             }
-            ++s;
-            light = !light;
+            *out++ = '|';
+            *out++ = ' ';
+            *out++ = ' ';
+            *out++ = i == 2 ? '1' + r : ' ';
+            *out++ = '\n';
          }
-         out << '|';
 
-         if (i == 2) {
-            out << "  " << r + 1;
-         } else {
-            out << "   ";
-         }
+         // draw bottom ruler
+         memcpy(out, ruler, AsciiBoard::rowL);
+         out += AsciiBoard::rowL;
 
-         out << '\n';
-         ++s;
+         // next row starts with other color
+         light = !light;
       }
+      memcpy(out, letters, sizeof(letters) - 1);
+   }
+};
 
-      // draw bottom ruler
-      out << "|----------+----------+----------+----------+----------+----------+----------+----------|   \n";
-
-      // next row starts with other color
-      light = !light;
+//------------------------------------------------------------------------------
+bool writeAll (int fd, char const* p, int left) {
+   while (left > 0) {
+      ssize_t n = ::write(fd, p, left);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+         return false;
+      p += n;
+      left -= n;
    }
-   out << "     A          B          C          D          E          F          G          H\n";
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Empty squares hold the board's path dependent data, which isn't drawn.
+inline Piece drawnPiece (BitBoard const& b, Square s) {
+   Piece p = b.get(s);
+   return isPiece(p) ? p : PC::c0;
+}
+
+//------------------------------------------------------------------------------
+Template const& emptyBoard (bool negativeSpaceIsDark) {
+   static Template const dark(true);
+   static Template const light(false);
+   return negativeSpaceIsDark ? dark : light;
+}
+
+}
+
+
+//------------------------------------------------------------------------------
+AsciiBoard::AsciiBoard (BitBoard const& b): negativeSpaceIsDark(true) {
+   render(b);
+}
+
+//------------------------------------------------------------------------------
+void AsciiBoard::render (BitBoard const& b) {
+   Trace::Scope scope("render", "board");
+   memcpy(str, emptyBoard(negativeSpaceIsDark).str, size);
 
    // Superimpose Pieces
-   str = out.str();
    for (PieceItr itr(b, PieceItr::all_pieces); itr.valid(); ++itr) {
       int x = file(itr.square()) * 11 + 1;
       int y = (7 - rank(itr.square())) * 5 + 1;
@@ -85,10 +132,63 @@ AsciiBoard::AsciiBoard (BitBoard const& b) {
    }
 }
 
+//------------------------------------------------------------------------------
+bool AsciiBoard::write (int fd) const {
+   return writeAll(fd, str, size);
+}
+
 //------------------------------------------------------------------------------
 std::ostream& operator<< (std::ostream& os, AsciiBoard const& ab) {
-   // Output to cout
-   return os << ab.str;
+   return os.write(ab.str, AsciiBoard::size);
+}
+
+//------------------------------------------------------------------------------
+// Not knowing the size (ex, output isn't a terminal) counts as unchanged.
+bool AsciiTerminal::resized () {
+   struct winsize size;
+   if (ioctl(_fd, TIOCGWINSZ, &size) != 0 || (size.ws_row == _rows && size.ws_col == _columns))
+      return false;
+   _rows = size.ws_row;
+   _columns = size.ws_col;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool AsciiTerminal::show (BitBoard const& b) {
+   Trace::Scope scope("render", "terminal");
+   bool full = resized() || !_drawn;
+   _board.render(b);
+   char* out = _out;
+   if (full) {
+      // home, clear, then the whole board
+      memcpy(out, "\x1b[H\x1b[2J", 7);
+      out += 7;
+      memcpy(out, _board.data(), AsciiBoard::size);
+      out += AsciiBoard::size;
+   } else {
+      for (Square s=0; s<64; ++s) {
+         if (drawnPiece(b, s) == drawnPiece(_shown, s))
+            continue;
+         // the cell's four lines, inside its borders
+         int x = file(s) * 11 + 1;
+         int y = (7 - rank(s)) * 5 + 1;
+         for (int line=0; line<4; ++line) {
+            out += std::sprintf(out, "\x1b[%d;%dH", y + line + 1, x + 1);
+            memcpy(out, _board.data() + (y + line) * AsciiBoard::rowL + x, 10);
+            out += 10;
+         }
+      }
+      if (out == _out) {
+         _written = 0;
+         return true;
+      }
+      // below the file letters, where a full draw leaves it
+      out += std::sprintf(out, "\x1b[%d;1H", 43);
+   }
+   _shown = b;
+   _drawn = true;
+   _written = out - _out;
+   return writeAll(_fd, _out, _written);
 }
 
 //------------------------------------------------------------------------------
@@ -7,16 +7,32 @@
 #define ASCII_BOARD
 
 #include "Chess.h"
-#include <sstream>
+#include <ostream>
 
 
 //------------------------------------------------------------------------------
+// Renders a position as 93 column ASCII art.
+/*
+ * The empty board is built once (for each coloring) and shared. Rendering
+ * copies it into the board's own buffer and stamps the pieces over it, so an
+ * AsciiBoard kept around and rendered again allocates nothing.
+ */
 struct AsciiBoard {
-   std::string str;
+   static const int rowL = 93;
+   // 41 rows of squares and rulers, then the file letters
+   static const int size = 41 * rowL + 84;
+
+   char str[size];
    bool negativeSpaceIsDark;
 
+   AsciiBoard (): negativeSpaceIsDark(true) {}
    AsciiBoard (BitBoard const& b);
 
+   void render (BitBoard const& b);
+   char const* data () const { return str; }
+   // writes the rendering to a file descriptor; false on a write error
+   bool write (int fd) const;
+
    void drawEmptyPawn   (int i);
    void drawEmptyKnight (int i);
    void drawEmptyBishop (int i);
@@ -29,10 +45,44 @@ struct AsciiBoard {
    void drawFilledRook   (int i);
    void drawFilledQueen  (int i);
    void drawFilledKing   (int i);
-
-   static const int rowL = 93;
 };
 
 std::ostream& operator<< (std::ostream& os, AsciiBoard const& ab);
 
+//------------------------------------------------------------------------------
+// Keeps a board on an ANSI terminal up to date, redrawing only what changed.
+/*
+ * The first board (and any board after the terminal was resized, or after
+ * invalidate) is drawn in full at the top left. After that only the 10x4
+ * cells of squares whose piece changed are rewritten, each line reached with
+ * a cursor positioning sequence, so a move costs a couple hundred bytes
+ * instead of the whole 3.8 KB board. Everything a call draws goes out in one
+ * write, and the cursor is left below the board.
+ */
+class AsciiTerminal {
+private:
+   int _fd;
+   AsciiBoard _board;
+   BitBoard _shown;
+   bool _drawn;
+   unsigned short _rows;
+   unsigned short _columns;
+   unsigned _written;
+   // a full board plus escapes, or every cell with its cursor moves
+   char _out[8192];
+
+public:
+   AsciiTerminal (int fd): _fd(fd), _drawn(false), _rows(0), _columns(0), _written(0) {}
+
+   // false on a write error
+   bool show (BitBoard const& b);
+   // the next show draws everything
+   void invalidate () { _drawn = false; }
+   // bytes the last show wrote
+   unsigned written () const { return _written; }
+
+private:
+   bool resized ();
+};
+
 #endif
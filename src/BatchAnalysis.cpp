@@ -0,0 +1,171 @@
+//==============================================================================
+// BatchAnalysis.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "BatchAnalysis.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include "Fen.h"
+#include "GambitInterface.h"
+#include "Trace.h"
+
+
+//==============================================================================
+// Batch Analysis
+//==============================================================================
+
+//------------------------------------------------------------------------------
+BatchAnalysis::BatchAnalysis (unsigned threads, unsigned megabytes, SearchLimits const& limits,
+                              unsigned window):
+   _limits(limits), _threads(threads ? threads : 1), _taken(0), _read(0), _written(0),
+   _done(false), _out(0)
+{
+   _tt.resize(megabytes);
+   _slots.resize(window ? window : 4 * _threads);
+}
+
+//------------------------------------------------------------------------------
+bool BatchAnalysis::run (int fd, AsyncWriter& out) {
+   _out = &out;
+   std::vector<std::thread> workers;
+   for (unsigned i=0; i<_threads; ++i)
+      workers.push_back(std::thread(&BatchAnalysis::work, this));
+
+   // lines are cut from the buffer as they complete; a partial line waits
+   // for the next read
+   std::string buffer;
+   char chunk[1 << 16];
+   bool ok = true;
+   while (true) {
+      ssize_t n;
+      {
+         Trace::Scope scope("io", "read");
+         n = ::read(fd, chunk, sizeof(chunk));
+         scope.setArg(n);
+      }
+      if (n < 0)
+         ok = false;
+      if (n <= 0)
+         break;
+      buffer.append(chunk, n);
+      size_t start = 0;
+      for (size_t end; (end = buffer.find('\n', start)) != std::string::npos; start = end + 1)
+         add(buffer.substr(start, end - start));
+      buffer.erase(0, start);
+   }
+   if (!buffer.empty())
+      add(buffer);
+
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done = true;
+   }
+   _work.notify_all();
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+   out.flush();
+   return ok;
+}
+
+//------------------------------------------------------------------------------
+// Queues a line, waiting while the window is full.
+void BatchAnalysis::add (std::string const& line) {
+   if (!line.empty() && line[line.size() - 1] == '\r') {
+      add(line.substr(0, line.size() - 1));
+      return;
+   }
+   if (line.empty() || line[0] == '#')
+      return;
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (_read - _written >= _slots.size())
+      _space.wait(lock);
+   _pending.push_back(line);
+   ++_read;
+   lock.unlock();
+   _work.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void BatchAnalysis::work () {
+   Trace::nameThread("analysis");
+   Searcher searcher;
+   searcher.setSharedTable(&_tt);
+
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (true) {
+      while (!_done && _pending.empty())
+         _work.wait(lock);
+      if (_pending.empty())
+         return;
+      std::string line;
+      line.swap(_pending.front());
+      _pending.pop_front();
+      unsigned long long sequence = _taken++;
+      lock.unlock();
+
+      std::string result = analyze(searcher, line);
+
+      lock.lock();
+      Slot& slot = _slots[sequence % _slots.size()];
+      slot.text.swap(result);
+      slot.ready = true;
+      // write everything now in order; the writer never blocks on output
+      bool advanced = false;
+      for (Slot* next = &_slots[_written % _slots.size()];
+           next->ready && _written < _read;
+           next = &_slots[_written % _slots.size()]) {
+         _out->line(next->text);
+         next->ready = false;
+         ++_written;
+         advanced = true;
+      }
+      if (advanced)
+         _space.notify_one();
+   }
+}
+
+//------------------------------------------------------------------------------
+std::string BatchAnalysis::analyze (Searcher& searcher, std::string const& line) {
+   Trace::Scope scope("analysis", "position");
+   char const* begin = line.c_str();
+   char const* end = begin + line.size();
+   Board b;
+   // EPD operations end in ';', and a FEN has none
+   char const* operations = end;
+   bool epd = line.find(';') != std::string::npos;
+   if (epd ? !Fen::readEpd(begin, end, b, operations) : !Fen::read(begin, end, b))
+      return "error bad position";
+
+   std::string text;
+   char const* id;
+   unsigned length;
+   if (operations < end && Fen::findOperation(operations, end, "id", id, length)) {
+      text = "id ";
+      text.append(id, length);
+      text += ' ';
+   }
+
+   Move best = searcher.search(b, _limits);
+   if (!best.valid())
+      return text + (isCheckmate(b) ? "bestmove (none) checkmate" : "bestmove (none) stalemate");
+
+   char buffer[128];
+   char move[8];
+   *best.writeCoordinates(move) = 0;
+   int score = searcher.score();
+   int n;
+   if (score > Score::mateBound)
+      n = snprintf(buffer, sizeof(buffer), "bestmove %s score mate %d", move, (Score::mate - score + 1) / 2);
+   else if (score < -Score::mateBound)
+      n = snprintf(buffer, sizeof(buffer), "bestmove %s score mate %d", move, -(Score::mate + score) / 2);
+   else
+      n = snprintf(buffer, sizeof(buffer), "bestmove %s score cp %d", move, score);
+   text.append(buffer, n);
+   n = snprintf(buffer, sizeof(buffer), " depth %u nodes %llu", searcher.completedDepth(),
+                searcher.nodes());
+   text.append(buffer, n);
+   return text;
+}
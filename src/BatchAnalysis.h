@@ -0,0 +1,87 @@
+//==============================================================================
+// BatchAnalysis.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef BATCHANALYSIS
+#define BATCHANALYSIS
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Search.h"
+
+class AsyncWriter;
+
+
+//==============================================================================
+// Batch Analysis
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Analyzes a stream of FEN or EPD lines on a pool of searchers and writes one
+// result line per position, in input order.
+/*
+ * The reading thread hands out lines by sequence number; each worker parses
+ * and searches its own line and parks the result in a reorder buffer of
+ * window slots. Whoever completes the oldest outstanding result writes it and
+ * every result queued behind it. The reader never gets more than window lines
+ * ahead of the output, which bounds both the memory held and how long a line
+ * can wait behind slower ones.
+ *
+ * Every worker has its own Searcher (so its history and killers carry over)
+ * but all share one transposition table that is never cleared, so positions
+ * from the same game or opening find each other's work wherever they land.
+ *
+ * Result lines are "bestmove <move> score cp <n> depth <d> nodes <n>" (or
+ * "score mate <n>", as in UCI), prefixed with the EPD id if there is one, or
+ * "error <reason>" for a line that isn't a position. Blank lines and lines
+ * starting with '#' are skipped.
+ */
+class BatchAnalysis {
+private:
+   struct Slot {
+      bool ready;
+      std::string text;
+      Slot (): ready(false) {}
+   };
+
+   TranspositionTable _tt;
+   SearchLimits _limits;
+   unsigned _threads;
+
+   std::mutex _mutex;
+   std::condition_variable _work;
+   std::condition_variable _space;
+   // lines read but not yet taken by a worker, oldest first
+   std::deque<std::string> _pending;
+   unsigned long long _taken;   // sequence number of _pending.front()
+   unsigned long long _read;
+   unsigned long long _written;
+   std::vector<Slot> _slots;
+   bool _done;
+   AsyncWriter* _out;
+
+   BatchAnalysis (BatchAnalysis const&);
+   void operator= (BatchAnalysis const&);
+
+public:
+   // window is the most lines in flight at once (0 for 4 per thread)
+   BatchAnalysis (unsigned threads, unsigned megabytes, SearchLimits const& limits,
+                  unsigned window = 0);
+
+   // analyzes every line of fd until end of file, writing results to out;
+   // returns false on a read error
+   bool run (int fd, AsyncWriter& out);
+   unsigned long long positions () const { return _written; }
+
+private:
+   void add (std::string const& line);
+   void work ();
+   std::string analyze (Searcher& searcher, std::string const& line);
+};
+
+
+#endif
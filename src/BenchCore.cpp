@@ -0,0 +1,382 @@
+//==============================================================================
+// BenchCore.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "Chess.h"
+#include "Fen.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Positions full of pieces (and special moves) to sweep.
+char const* const denseFens[] = {
+   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+   "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+   "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+   "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+   "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"
+};
+
+// Endgames, where most squares are empty and long range pieces run far.
+char const* const sparseFens[] = {
+   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+   "8/8/8/8/8/8/6k1/4K2R w K - 0 1",
+   "8/5k2/8/3Q4/8/8/8/4K3 w - - 0 1",
+   "6k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 0 1",
+   "8/8/4k3/8/2b5/8/4K3/3R4 b - - 0 1",
+   "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2"
+};
+
+//------------------------------------------------------------------------------
+// Cycles from the time stamp counter, where there is one (0 elsewhere).
+inline unsigned long long cyclesNow () {
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   return 0;
+#endif
+}
+
+inline long long nanosecondsNow () {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+   ).count();
+}
+
+// results are summed into this so the compiler can't drop the work
+volatile unsigned long long sink;
+
+//------------------------------------------------------------------------------
+struct Result {
+   std::string name;
+   unsigned long long opsPerSample;
+   unsigned samples;
+   double medianNs;
+   double p99Ns;
+   double medianCycles;
+   double p99Cycles;
+};
+
+//------------------------------------------------------------------------------
+// Runs each benchmark for warmup samples, then timed ones.
+/*
+ * A benchmark is a function that does its unit of work n times and returns
+ * something to fold into the sink. Before warming up, n is doubled until a
+ * sample takes at least sampleNs, so timer overhead stays negligible. Each
+ * sample is timed on its own and reported per op; medians resist the odd
+ * interrupt, and the 99th percentile shows how often those come.
+ */
+class Harness {
+private:
+   unsigned _warmup;
+   unsigned _repetitions;
+   std::string _filter;
+   std::vector<Result> _results;
+
+public:
+   static const long long sampleNs = 200000;
+
+   Harness (unsigned warmup, unsigned repetitions, char const* filter):
+      _warmup(warmup), _repetitions(repetitions), _filter(filter) {}
+
+   std::vector<Result> const& results () const { return _results; }
+
+   // opsPerUnit is how many ops one unit of work does (ex, squares swept)
+   template <typename Work>
+   void run (char const* name, unsigned long long opsPerUnit, Work work) {
+      if (strncmp(name, _filter.c_str(), _filter.size()) != 0)
+         return;
+
+      unsigned long long n = 1;
+      for (;;) {
+         long long start = nanosecondsNow();
+         sink += work(n);
+         if (nanosecondsNow() - start >= sampleNs || n >= (1ull << 40))
+            break;
+         n *= 2;
+      }
+      for (unsigned i=0; i<_warmup; ++i)
+         sink += work(n);
+
+      std::vector<double> ns(_repetitions);
+      std::vector<double> cycles(_repetitions);
+      double ops = static_cast<double>(n * opsPerUnit);
+      for (unsigned i=0; i<_repetitions; ++i) {
+         long long start = nanosecondsNow();
+         unsigned long long startCycles = cyclesNow();
+         sink += work(n);
+         unsigned long long endCycles = cyclesNow();
+         ns[i] = (nanosecondsNow() - start) / ops;
+         cycles[i] = (endCycles - startCycles) / ops;
+      }
+      std::sort(ns.begin(), ns.end());
+      std::sort(cycles.begin(), cycles.end());
+
+      Result r;
+      r.name = name;
+      r.opsPerSample = n * opsPerUnit;
+      r.samples = _repetitions;
+      r.medianNs = ns[_repetitions / 2];
+      r.p99Ns = ns[_repetitions * 99 / 100];
+      r.medianCycles = cycles[_repetitions / 2];
+      r.p99Cycles = cycles[_repetitions * 99 / 100];
+      _results.push_back(r);
+      fprintf(stderr, "%-28s %10.2f ns %10.2f cycles  (p99 %.2f ns, %.2f cycles)\n", name,
+              r.medianNs, r.medianCycles, r.p99Ns, r.p99Cycles);
+   }
+};
+
+//------------------------------------------------------------------------------
+std::vector<Board> readBoards (char const* const* fens, unsigned count) {
+   std::vector<Board> boards(count);
+   for (unsigned i=0; i<count; ++i) {
+      if (!Fen::read(fens[i], boards[i])) {
+         fprintf(stderr, "bad benchmark position %s\n", fens[i]);
+         exit(1);
+      }
+   }
+   return boards;
+}
+
+//------------------------------------------------------------------------------
+// Every path independent move of every piece on every board.
+unsigned long long sweepPathIndependent (std::vector<Board> const& boards) {
+   unsigned long long sum = 0;
+   PathIndependentGen gen;
+   for (unsigned i=0; i<boards.size(); ++i) {
+      gen.setBoard(boards[i].bitboard());
+      for (PieceItr itr(boards[i].bitboard(), PieceItr::all_pieces); itr.valid(); ++itr) {
+         for (gen.setSource(itr.square()); gen.valid(); ++gen)
+            sum += gen.dst();
+      }
+   }
+   return sum;
+}
+
+//------------------------------------------------------------------------------
+void writeJson (std::FILE* out, std::vector<Result> const& results,
+                unsigned warmup, unsigned repetitions) {
+   fprintf(out, "{\n  \"benchmark\": \"bench_core\",\n");
+   fprintf(out, "  \"cycles\": \"%s\",\n", cyclesNow() ? "rdtsc" : "none");
+   fprintf(out, "  \"warmup\": %u,\n  \"repetitions\": %u,\n", warmup, repetitions);
+   fprintf(out, "  \"results\": [");
+   for (unsigned i=0; i<results.size(); ++i) {
+      Result const& r = results[i];
+      fprintf(out, "%s\n    {\"name\": \"%s\", \"ops_per_sample\": %llu, \"samples\": %u, "
+              "\"median_ns\": %.3f, \"p99_ns\": %.3f, \"median_cycles\": %.3f, \"p99_cycles\": %.3f}",
+              i ? "," : "", r.name.c_str(), r.opsPerSample, r.samples,
+              r.medianNs, r.p99Ns, r.medianCycles, r.p99Cycles);
+   }
+   fprintf(out, "\n  ]\n}\n");
+}
+
+}
+
+
+//------------------------------------------------------------------------------
+// bench_core [repetitions] [name prefix] [json file]: times the board, generator
+// and arbiter primitives one op at a time. A table goes to stderr and JSON to
+// the file (stdout by default), for comparing commits.
+int main (int argc, char** argv) {
+   unsigned repetitions = argc > 1 ? atoi(argv[1]) : 101;
+   char const* filter = argc > 2 ? argv[2] : "";
+   if (repetitions == 0) {
+      fprintf(stderr, "usage: %s [repetitions] [name prefix] [json file]\n", argv[0]);
+      return 1;
+   }
+   std::FILE* out = stdout;
+   if (argc > 3 && !(out = std::fopen(argv[3], "w"))) {
+      fprintf(stderr, "can't write %s\n", argv[3]);
+      return 1;
+   }
+   unsigned warmup = 10;
+   Harness harness(warmup, repetitions, filter);
+
+   std::vector<Board> dense = readBoards(denseFens, sizeof(denseFens) / sizeof(denseFens[0]));
+   std::vector<Board> sparse = readBoards(sparseFens, sizeof(sparseFens) / sizeof(sparseFens[0]));
+   std::vector<Board> all(dense);
+   all.insert(all.end(), sparse.begin(), sparse.end());
+   unsigned long long boards = all.size();
+
+   //---------------------------------------------------------------------------
+   // BitBoard
+   harness.run("bitboard.get", 64 * boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      for (unsigned long long k=0; k<n; ++k)
+         for (unsigned i=0; i<all.size(); ++i)
+            for (Square s=0; s<64; ++s)
+               sum += all[i].bitboard().get(s);
+      return sum;
+   });
+   harness.run("bitboard.set", 64 * boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      for (unsigned long long k=0; k<n; ++k) {
+         for (unsigned i=0; i<all.size(); ++i) {
+            BitBoard b(all[i].bitboard());
+            for (Square s=0; s<64; ++s)
+               b.set(s, (s + k) & 0xf);
+            sum += b.words()[k & 7];
+         }
+      }
+      return sum;
+   });
+   harness.run("bitboard.hash", boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      for (unsigned long long k=0; k<n; ++k)
+         for (unsigned i=0; i<all.size(); ++i)
+            sum += all[i].bitboard().hash();
+      return sum;
+   });
+
+   //---------------------------------------------------------------------------
+   // MovementGenerator, every motion from every square
+   static const Piece pieces[] = { PC::p0, PC::p1, PC::n0, PC::b0, PC::r0, PC::q0, PC::k0 };
+   static char const* const pieceNames[] = {
+      "movement.light_pawn", "movement.dark_pawn", "movement.knight", "movement.bishop",
+      "movement.rook", "movement.queen", "movement.king"
+   };
+   for (unsigned p=0; p<sizeof(pieces) / sizeof(pieces[0]); ++p) {
+      Piece piece = pieces[p];
+      harness.run(pieceNames[p], 64, [piece] (unsigned long long n) {
+         unsigned long long sum = 0;
+         MovementGenerator gen;
+         gen.setPiece(piece);
+         for (unsigned long long k=0; k<n; ++k) {
+            for (Square s=0; s<64; ++s)
+               for (gen.setSource(s); gen.valid(); ++gen)
+                  sum += gen.dst();
+         }
+         return sum;
+      });
+   }
+
+   //---------------------------------------------------------------------------
+   // PathIndependentGen, per board swept
+   harness.run("pathindependent.dense", dense.size(), [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      for (unsigned long long k=0; k<n; ++k)
+         sum += sweepPathIndependent(dense);
+      return sum;
+   });
+   harness.run("pathindependent.sparse", sparse.size(), [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      for (unsigned long long k=0; k<n; ++k)
+         sum += sweepPathIndependent(sparse);
+      return sum;
+   });
+
+   //---------------------------------------------------------------------------
+   // Move lists, per board
+   harness.run("generate.pseudoLegal", boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      MoveList list;
+      for (unsigned long long k=0; k<n; ++k)
+         for (unsigned i=0; i<all.size(); ++i) {
+            generatePseudoLegalMoves(all[i], list);
+            sum += list.size;
+         }
+      return sum;
+   });
+   harness.run("generate.captures", boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      MoveList list;
+      for (unsigned long long k=0; k<n; ++k)
+         for (unsigned i=0; i<all.size(); ++i) {
+            generateCaptures(all[i], list);
+            sum += list.size;
+         }
+      return sum;
+   });
+   harness.run("generate.quietChecks", boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      MoveList list;
+      for (unsigned long long k=0; k<n; ++k)
+         for (unsigned i=0; i<all.size(); ++i) {
+            generateQuietChecks(all[i], list);
+            sum += list.size;
+         }
+      return sum;
+   });
+
+   //---------------------------------------------------------------------------
+   // PathIndependentArbiter
+   harness.run("arbiter.isInCheck", 2 * boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      PathIndependentArbiter arbiter;
+      for (unsigned long long k=0; k<n; ++k) {
+         for (unsigned i=0; i<all.size(); ++i) {
+            sum += arbiter.isInCheck(all[i].bitboard(), true);
+            sum += arbiter.isInCheck(all[i].bitboard(), false);
+         }
+      }
+      return sum;
+   });
+   harness.run("arbiter.isThreatened", 64 * boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      PathIndependentArbiter arbiter;
+      for (unsigned long long k=0; k<n; ++k) {
+         for (unsigned i=0; i<all.size(); ++i) {
+            bool light = all[i].pathDependence().lightMove();
+            for (Square s=0; s<64; ++s)
+               sum += arbiter.isThreatened(all[i].bitboard(), s, light);
+         }
+      }
+      return sum;
+   });
+
+   //---------------------------------------------------------------------------
+   // Board
+   harness.run("board.testSpecialMoves", boards, [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      Board b;
+      for (unsigned long long k=0; k<n; ++k) {
+         for (unsigned i=0; i<all.size(); ++i) {
+            b = all[i];
+            b.testSpecialMoves();
+            sum += b.specialMoves().canCastleShort() + b.specialMoves().canEnPassantLeft();
+         }
+      }
+      return sum;
+   });
+
+   std::vector<std::pair<unsigned, Move> > moves;
+   for (unsigned i=0; i<all.size(); ++i) {
+      MoveList list;
+      generateLegalMoves(all[i], list);
+      for (unsigned j=0; j<list.size; ++j)
+         moves.push_back(std::make_pair(i, list[j]));
+   }
+   harness.run("board.realize", moves.size(), [&] (unsigned long long n) {
+      unsigned long long sum = 0;
+      Board child;
+      for (unsigned long long k=0; k<n; ++k) {
+         for (unsigned i=0; i<moves.size(); ++i) {
+            all[moves[i].first].realize(moves[i].second, child);
+            sum += child.pawnKey;
+         }
+      }
+      return sum;
+   });
+
+   writeJson(out, harness.results(), warmup, repetitions);
+   if (out != stdout)
+      std::fclose(out);
+   return 0;
+}
@@ -0,0 +1,105 @@
+//==============================================================================
+// Book.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef BOOK
+#define BOOK
+
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+
+
+//==============================================================================
+// Polyglot Keys and Moves
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// The position keys and move encoding of Polyglot opening books.
+/*
+ * A key xors one random number per (piece, square), per castling right, for
+ * an en passant file (only if a pawn of the side to move stands beside the
+ * pawn that advanced) and for light to move: 781 numbers in all. These keys
+ * are separate from the engine's own hash (see positionKey in Search.h).
+ *
+ * The table is the published Polyglot one, so books made by other programs
+ * and by BookWriter read the same.
+ */
+namespace Polyglot {
+   static const unsigned keyCount = 781;
+   extern HashKey const random64[keyCount];
+
+   HashKey key (Board const& b);
+
+   // Polyglot moves are from and to squares plus a promotion piece, and
+   // castling is written as the king taking its own rook (ex, e1h1)
+   unsigned short encodeMove (Move const& m);
+   // the legal move of b the book move stands for, or an invalid move
+   Move decodeMove (Board const& b, unsigned short move);
+}
+
+
+//==============================================================================
+// Opening Book
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// One 16 byte book entry as stored: all fields big endian.
+struct BookEntry {
+   unsigned char bytes[16];
+
+   HashKey key () const;
+   unsigned short move () const { return (bytes[8] << 8) | bytes[9]; }
+   unsigned short weight () const { return (bytes[10] << 8) | bytes[11]; }
+   void set (HashKey key, unsigned short move, unsigned short weight);
+};
+
+//------------------------------------------------------------------------------
+// A mapped Polyglot book. Entries are sorted by key, so a lookup is a binary
+// search over the mapping and allocates nothing.
+class OpeningBook {
+private:
+   MappedFile _file;
+   BookEntry const* _entries;
+   unsigned long long _size;
+
+public:
+   OpeningBook (): _entries(0), _size(0) {}
+   // fails if the file isn't a whole number of entries
+   bool open (char const* path);
+   void close () { _file.close(); _entries = 0; _size = 0; }
+   bool isOpen () const { return _entries != 0; }
+   unsigned long long size () const { return _size; }
+
+   // the entries for key; returns how many there are
+   unsigned find (HashKey key, BookEntry const*& first) const;
+   // picks one of b's book moves with probability proportional to its weight;
+   // random is any uniformly distributed number. Returns an invalid move if
+   // b isn't in the book.
+   Move probe (Board const& b, unsigned long long random) const;
+};
+
+//------------------------------------------------------------------------------
+// Collects (position, move, weight) and writes a sorted Polyglot book.
+class BookWriter {
+private:
+   struct Item {
+      HashKey key;
+      unsigned short move;
+      unsigned weight;
+      bool operator< (Item const& i) const {
+         return key != i.key ? key < i.key : move < i.move;
+      }
+   };
+   std::vector<Item> _items;
+
+public:
+   void add (Board const& b, Move const& m, unsigned weight);
+   // merges repeated moves, scales weights to 16 bits and drops moves left
+   // with no weight; returns the number of entries written, or -1 on failure
+   long long write (char const* path);
+};
+
+
+#endif
@@ -6,6 +6,36 @@
 #include "Chess.h"
 
 
+//==============================================================================
+// Zobrist Keys
+//==============================================================================
+
+HashKey Zobrist::pawnKeys[2][64];
+
+namespace {
+
+//------------------------------------------------------------------------------
+// splitmix64, so the keys are the same on every run and every platform
+HashKey nextRandom (HashKey& state) {
+   HashKey z = (state += 0x9e3779b97f4a7c15ull);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+   return z ^ (z >> 31);
+}
+
+//------------------------------------------------------------------------------
+struct ZobristInitializer {
+   ZobristInitializer () {
+      HashKey state = 0x70a77ca5ull;
+      for (unsigned c=0; c<2; ++c)
+         for (Square s=0; s<64; ++s)
+            Zobrist::pawnKeys[c][s] = nextRandom(state);
+   }
+} zobristInitializer;
+
+}
+
+
 //==============================================================================
 // BitBoard
 //==============================================================================
@@ -46,16 +76,16 @@ void BitBoard::lightCastleLong () {
 //------------------------------------------------------------------------------
 void BitBoard::darkCastleShort () {
    set(60, PC::c0);
-   set(61, PC::r0);
-   set(62, PC::k0);
+   set(61, PC::r1);
+   set(62, PC::k1);
    set(63, PC::c0);
 }
 
 //------------------------------------------------------------------------------
 void BitBoard::darkCastleLong () {
    set(56, PC::c0);
-   set(58, PC::k0);
-   set(59, PC::r0);
+   set(58, PC::k1);
+   set(59, PC::r1);
    set(60, PC::c0);
 }
 
@@ -88,6 +118,22 @@ void BitBoard::darkEnPassantRight (unsigned file) {
 }
 
 
+//==============================================================================
+// Move Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+char* Move::writeCoordinates (char* out) const {
+   *out++ = 'a' + file(src);
+   *out++ = '1' + rank(src);
+   *out++ = 'a' + file(dst);
+   *out++ = '1' + rank(dst);
+   if (isPromotion())
+      *out++ = "nbrq"[kind - promoteKnight];
+   return out;
+}
+
+
 //==============================================================================
 // MovementGenerator Methods
 //==============================================================================
@@ -489,6 +535,7 @@ void PathIndependentGen::advanceNormal () {
 
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::isInCheck (BitBoard const& b, bool light) {
+   COUNT(isInCheck);
    gen.setBoard(b);
    gen.setColor(light);
 
@@ -508,20 +555,57 @@ bool PathIndependentArbiter::isInCheck (BitBoard const& b, bool light) {
 }
 
 //------------------------------------------------------------------------------
+// Looks outward from s for attackers, rather than generating every enemy move:
+// pawns attack squares they could never move to (when those squares are empty).
 bool PathIndependentArbiter::isThreatened (BitBoard const& b, Square s, bool light) {
-   gen.setBoard(b);
-   gen.setColor(light);
+   COUNT(isThreatened);
+   int r = rank(s);
+   int f = file(s);
+
+   Piece pawn   = light ? PC::p1 : PC::p0;
+   Piece knight = light ? PC::n1 : PC::n0;
+   Piece bishop = light ? PC::b1 : PC::b0;
+   Piece rook   = light ? PC::r1 : PC::r0;
+   Piece queen  = light ? PC::q1 : PC::q0;
+   Piece king   = light ? PC::k1 : PC::k0;
+
+   // pawns attack diagonally forward (so from behind, as seen from s)
+   int pr = light ? r + 1 : r - 1;
+   if (0 <= pr && pr < 8) {
+      if (f > 0 && b.get((pr << 3) + f - 1) == pawn) return true;
+      if (f < 7 && b.get((pr << 3) + f + 1) == pawn) return true;
+   }
 
-   PieceItr itr(b, light ? PieceItr::dark_pieces : PieceItr::light_pieces);
-   while (itr.valid()) {
-      gen.setSource(itr.square());
-      while (gen.valid()) {
-         if (gen.dst() == s) {
-            return true;
+   static const int knightSteps[8][2] = {
+      {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+   };
+   for (int i=0; i<8; ++i) {
+      int rr = r + knightSteps[i][0];
+      int ff = f + knightSteps[i][1];
+      if (0 <= rr && rr < 8 && 0 <= ff && ff < 8 && b.get((rr << 3) + ff) == knight)
+         return true;
+   }
+
+   // kings, then sliding pieces, along the eight directions
+   static const int directions[8][2] = {
+      {0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {1, -1}, {-1, -1}, {-1, 1}
+   };
+   for (int i=0; i<8; ++i) {
+      bool diagonal = i >= 4;
+      int rr = r + directions[i][0];
+      int ff = f + directions[i][1];
+      bool adjacent = true;
+      while (0 <= rr && rr < 8 && 0 <= ff && ff < 8) {
+         Piece p = b.get((rr << 3) + ff);
+         if (isPiece(p)) {
+            if (adjacent && p == king) return true;
+            if (p == queen || p == (diagonal ? bishop : rook)) return true;
+            break;
          }
-         ++gen;
+         rr += directions[i][0];
+         ff += directions[i][1];
+         adjacent = false;
       }
-      ++itr;
    }
 
    return false;
@@ -530,10 +614,10 @@ bool PathIndependentArbiter::isThreatened (BitBoard const& b, Square s, bool lig
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyLightEnPassantLeft (BitBoard const& b, unsigned f) {
    BitBoard b2(b);
-   Square dst = 40 + f;
    Square src = 31 + f;
    if (f > 0 && b.get(src) == PC::p0) {
-      b2.move(src, dst);
+      // removing the captured pawn may expose the king along the rank
+      b2.lightEnPassantLeft(f);
       if (!isInCheck(b2, true))
          return true;
    }
@@ -543,10 +627,9 @@ bool PathIndependentArbiter::verifyLightEnPassantLeft (BitBoard const& b, unsign
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyLightEnPassantRight (BitBoard const& b, unsigned f) {
    BitBoard b2(b);
-   Square dst = 40 + f;
    Square src = 33 + f;
    if (f < 7 && b.get(src) == PC::p0) {
-      b2.move(src, dst);
+      b2.lightEnPassantRight(f);
       if (!isInCheck(b2, true))
          return true;
    }
@@ -556,10 +639,9 @@ bool PathIndependentArbiter::verifyLightEnPassantRight (BitBoard const& b, unsig
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyDarkEnPassantLeft (BitBoard const& b, unsigned f) {
    BitBoard b2(b);
-   Square dst = 16 + f;
    Square src = 23 + f;
    if (f > 0 && b.get(src) == PC::p1) {
-      b2.move(src, dst);
+      b2.darkEnPassantLeft(f);
       if (!isInCheck(b2, false))
          return true;
    }
@@ -569,10 +651,9 @@ bool PathIndependentArbiter::verifyDarkEnPassantLeft (BitBoard const& b, unsigne
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyDarkEnPassantRight (BitBoard const& b, unsigned f) {
    BitBoard b2(b);
-   Square dst = 16 + f;
    Square src = 25 + f;
    if (f < 7 && b.get(src) == PC::p1) {
-      b2.move(src, dst);
+      b2.darkEnPassantRight(f);
       if (!isInCheck(b2, false))
          return true;
    }
@@ -581,26 +662,27 @@ bool PathIndependentArbiter::verifyDarkEnPassantRight (BitBoard const& b, unsign
 
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyLightCastleShort (BitBoard const& b) {
-   return ( isEmpty(b.get(5)) && isEmpty(b.get(6)) && !isThreatened(b, 4, true)
+   return ( b.get(7) == PC::r0 && isEmpty(b.get(5)) && isEmpty(b.get(6)) && !isThreatened(b, 4, true)
         && !isThreatened(b, 5, true) && !isThreatened(b, 6, true) );
 }
 
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyDarkCastleShort (BitBoard const& b) {
-   return ( isEmpty(b.get(61)) && isEmpty(b.get(62)) && !isThreatened(b, 60, false)
+   return ( b.get(63) == PC::r1 && isEmpty(b.get(61)) && isEmpty(b.get(62)) && !isThreatened(b, 60, false)
         && !isThreatened(b, 61, false) && !isThreatened(b, 62, false) );
 }
 
 //------------------------------------------------------------------------------
+// The king never crosses b1 (b8), so it only needs to be empty.
 bool PathIndependentArbiter::verifyLightCastleLong (BitBoard const& b) {
-   return ( isEmpty(b.get(1)) && isEmpty(b.get(2)) && isEmpty(b.get(3)) && !isThreatened(b, 4, true)
-        && !isThreatened(b, 1, true) && !isThreatened(b, 2, true) && !isThreatened(b, 3, true) );
+   return ( b.get(0) == PC::r0 && isEmpty(b.get(1)) && isEmpty(b.get(2)) && isEmpty(b.get(3))
+        && !isThreatened(b, 4, true) && !isThreatened(b, 2, true) && !isThreatened(b, 3, true) );
 }
 
 //------------------------------------------------------------------------------
 bool PathIndependentArbiter::verifyDarkCastleLong (BitBoard const& b) {
-   return ( isEmpty(b.get(57)) && isEmpty(b.get(58)) && isEmpty(b.get(59)) && !isThreatened(b, 60, false)
-        && !isThreatened(b, 57, false) && !isThreatened(b, 58, false) && !isThreatened(b, 59, false) );
+   return ( b.get(56) == PC::r1 && isEmpty(b.get(57)) && isEmpty(b.get(58)) && isEmpty(b.get(59))
+        && !isThreatened(b, 60, false) && !isThreatened(b, 58, false) && !isThreatened(b, 59, false) );
 }
 
 
@@ -615,7 +697,9 @@ bool PathIndependentArbiter::verifyDarkCastleLong (BitBoard const& b) {
 
 //------------------------------------------------------------------------------
 void Board::testSpecialMoves () {
+   COUNT(testSpecialMoves);
    PathIndependentArbiter arbiter;
+   sm.clear();
 
    if (pd.lightMove()) {
       if (pd.pawnAdvanced2()) {
@@ -696,53 +780,90 @@ void Board::setupNewGame () {
    testSpecialMoves();
    findCodes();
    writeHashState();
+   computePawnKey();
 }
 
 //------------------------------------------------------------------------------
 void Board::realize (Generator const& generator, Board& child) const {
+   realize(generator.move(), child);
+}
+
+//------------------------------------------------------------------------------
+void Board::realize (Move const& move, Board& child) const {
+   COUNT(realize);
    child = *this;
    child.clearHashState();
+   child.pd.advanceClocks(isPawn(b.get(move.src)) || isPiece(b.get(move.dst)));
    child.pd.swapTurn();
    child.pd.clearPawnState();
 
-   if (generator.moveIsBasic()) {
-      child.b.move(generator.src(), generator.dst());
-      child.updatePDBasicMove(generator);
-   } else {
-      if (generator.specialMoveIsEPLeft()) {
+   switch (move.kind) {
+   case Move::basic: {
+      Piece p = b.get(move.src);
+      Piece captured = b.get(move.dst);
+      if (isPawn(p))
+         child.pawnKey ^= Zobrist::pawn(p, move.src) ^ Zobrist::pawn(p, move.dst);
+      if (isPawn(captured))
+         child.pawnKey ^= Zobrist::pawn(captured, move.dst);
+      child.b.move(move.src, move.dst);
+      child.updatePDBasicMove(move, p);
+      child.updatePDCapture(move.dst);
+      break;
+   }
+   case Move::promoteKnight:
+   case Move::promoteBishop:
+   case Move::promoteRook:
+   case Move::promoteQueen: {
+      Piece p = b.get(move.src);
+      child.pawnKey ^= Zobrist::pawn(p, move.src);
+      child.b.set(move.src, PC::c0);
+      child.b.set(move.dst, move.promotion(pd.lightMove()));
+      child.updatePDCapture(move.dst);
+      break;
+   }
+   case Move::epLeft:
+   case Move::epRight: {
+      // the captured pawn stands beside the capturing pawn's source
+      Piece p = b.get(move.src);
+      Piece captured = pd.lightMove() ? PC::p1 : PC::p0;
+      Square victim = (pd.lightMove() ? 32 : 24) + pd.pawnFile();
+      child.pawnKey ^= Zobrist::pawn(p, move.src) ^ Zobrist::pawn(p, move.dst)
+                     ^ Zobrist::pawn(captured, victim);
+      if (move.kind == Move::epLeft) {
          if (pd.lightMove())
-            child.b.lightEnPassantLeft(generator.enPassantFile());
+            child.b.lightEnPassantLeft(pd.pawnFile());
          else
-            child.b.darkEnPassantLeft(generator.enPassantFile());
-      }
-      if (generator.specialMoveIsEPRight()) {
+            child.b.darkEnPassantLeft(pd.pawnFile());
+      } else {
          if (pd.lightMove())
-            child.b.lightEnPassantRight(generator.enPassantFile());
+            child.b.lightEnPassantRight(pd.pawnFile());
          else
-            child.b.darkEnPassantRight(generator.enPassantFile());
+            child.b.darkEnPassantRight(pd.pawnFile());
       }
-      if (generator.specialMoveIsCastleShort()) {
-         if (pd.lightMove()) {
-            child.b.lightCastleShort();
-            child.pd.lightKingMoved();
-            child.pd.lightRook7Moved();
-         } else {
-            child.b.darkCastleShort();
-            child.pd.darkKingMoved();
-            child.pd.darkRook7Moved();
-         }
+      break;
+   }
+   case Move::castleShort:
+      if (pd.lightMove()) {
+         child.b.lightCastleShort();
+         child.pd.lightKingMoved();
+         child.pd.lightRook7Moved();
+      } else {
+         child.b.darkCastleShort();
+         child.pd.darkKingMoved();
+         child.pd.darkRook7Moved();
       }
-      if (generator.specialMoveIsCastleLong()) {
-         if (pd.lightMove()) {
-            child.b.lightCastleLong();
-            child.pd.lightKingMoved();
-            child.pd.lightRook0Moved();
-         } else {
-            child.b.darkCastleLong();
-            child.pd.darkKingMoved();
-            child.pd.darkRook0Moved();
-         }
+      break;
+   case Move::castleLong:
+      if (pd.lightMove()) {
+         child.b.lightCastleLong();
+         child.pd.lightKingMoved();
+         child.pd.lightRook0Moved();
+      } else {
+         child.b.darkCastleLong();
+         child.pd.darkKingMoved();
+         child.pd.darkRook0Moved();
       }
+      break;
    }
    child.testSpecialMoves();
    child.findCodes();
@@ -750,14 +871,21 @@ void Board::realize (Generator const& generator, Board& child) const {
 }
 
 //------------------------------------------------------------------------------
-void Board::updatePDBasicMove (Generator const& gen) {
-   // for convenience
-   Piece p = gen.srcPiece();
+void Board::realizeNull (Board& child) const {
+   child = *this;
+   child.clearHashState();
+   child.pd.pass();
+   child.testSpecialMoves();
+   child.findCodes();
+   child.writeHashState();
+}
 
+//------------------------------------------------------------------------------
+void Board::updatePDBasicMove (Move const& move, Piece p) {
    if (isLightPiece(p)) {
       // check if a light pawn double advanced
-      if ( p == PC::p0 && gen.pawnMoveIsAdvance2() ) {
-         pd.pawnAdvancedOnFile(file(gen.src()));
+      if ( p == PC::p0 && move.dst == move.src + 16 ) {
+         pd.pawnAdvancedOnFile(file(move.src));
          return;
       }
 
@@ -766,13 +894,13 @@ void Board::updatePDBasicMove (Generator const& gen) {
 
       // check if a light rook moved
       if (p == PC::r0) {
-         if (!pd.lightRook0() && gen.src() == 0) { pd.lightRook0Moved(); return; }
-         if (!pd.lightRook7() && gen.src() == 7) { pd.lightRook7Moved(); return; }
+         if (!pd.lightRook0() && move.src == 0) { pd.lightRook0Moved(); return; }
+         if (!pd.lightRook7() && move.src == 7) { pd.lightRook7Moved(); return; }
       }
    } else {
       // check if a dark pawn double advanced
-      if ( p == PC::p0 && gen.pawnMoveIsAdvance2() ) {
-         pd.pawnAdvancedOnFile(file(gen.src()));
+      if ( p == PC::p1 && move.src == move.dst + 16 ) {
+         pd.pawnAdvancedOnFile(file(move.src));
          return;
       }
 
@@ -781,14 +909,42 @@ void Board::updatePDBasicMove (Generator const& gen) {
 
       // check if a dark rook moved
       if (p == PC::r1) {
-         if (!pd.darkRook0() && gen.src() == 56) { pd.darkRook0Moved(); return; }
-         if (!pd.darkRook7() && gen.src() == 63) { pd.darkRook7Moved(); return; }
+         if (!pd.darkRook0() && move.src == 56) { pd.darkRook0Moved(); return; }
+         if (!pd.darkRook7() && move.src == 63) { pd.darkRook7Moved(); return; }
       }
    }
 }
 
 
 
+//------------------------------------------------------------------------------
+// A rook captured on its home square can no longer castle.
+void Board::updatePDCapture (Square dst) {
+   switch (dst) {
+   case 0:  pd.lightRook0Moved(); break;
+   case 7:  pd.lightRook7Moved(); break;
+   case 56: pd.darkRook0Moved();  break;
+   case 63: pd.darkRook7Moved();  break;
+   }
+}
+
+//------------------------------------------------------------------------------
+void Board::computePawnKey () {
+   pawnKey = 0;
+   for (PieceItr itr(b, PieceItr::all_pieces); itr.valid(); ++itr) {
+      if (isPawn(itr.piece()))
+         pawnKey ^= Zobrist::pawn(itr.piece(), itr.square());
+   }
+}
+
+//------------------------------------------------------------------------------
+void Board::finishSetup () {
+   testSpecialMoves();
+   findCodes();
+   writeHashState();
+   computePawnKey();
+}
+
 //------------------------------------------------------------------------------
 void Board::writeHashState () {
    if (pd.lightMove()) {
@@ -840,15 +996,16 @@ void Board::writeEnPassantFile () {
 //------------------------------------------------------------------------------
 void Generator::checkSpecialMoves () {
    switch (_state) {
+   // the capturing pawn must stand beside the pawn that just advanced
    case 0:
       if (isPawn(srcPiece()) && _board->sm.canEnPassantLeft()
-          && file(src()) == _board->pd.pawnFile() - 1
+          && src() == (lightMove() ? 31 : 23) + _board->pd.pawnFile()
       )
          return;
       ++_state;
    case 1:
       if (isPawn(srcPiece()) && _board->sm.canEnPassantRight()
-          && file(src()) == _board->pd.pawnFile() + 1
+          && src() == (lightMove() ? 33 : 25) + _board->pd.pawnFile()
       )
          return;
       ++_state;
@@ -862,6 +1019,29 @@ void Generator::checkSpecialMoves () {
 }
 
 
+//------------------------------------------------------------------------------
+Move Generator::move () const {
+   if (moveIsBasic()) {
+      if (moveIsPromotion())
+         return Move(src(), dst(), Move::promoteQueen - _promotion);
+      return Move(src(), dst(), Move::basic);
+   }
+
+   bool light = lightMove();
+   switch (_state) {
+   case 0:
+      return Move(src(), (light ? 40 : 16) + enPassantFile(), Move::epLeft);
+   case 1:
+      return Move(src(), (light ? 40 : 16) + enPassantFile(), Move::epRight);
+   case 2:
+      return light ? Move(4, 6, Move::castleShort) : Move(60, 62, Move::castleShort);
+   case 3:
+      return light ? Move(4, 2, Move::castleLong) : Move(60, 58, Move::castleLong);
+   }
+   return Move();
+}
+
+
 //==============================================================================
 // Arbiter Methods
 //==============================================================================
@@ -872,3 +1052,364 @@ bool Arbiter::putsOrLeavesInCheck (Board const& b, Generator const& gen) {
    return pia.isInCheck(b2.bitboard(), b2.pd.lightMove() ? false : true);
 }
 
+
+
+//==============================================================================
+// Move Generation
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// The unit step (dr, df) from s towards t, if they share a rank, file or
+// diagonal.
+bool direction (Square s, Square t, int& dr, int& df) {
+   int r = static_cast<int>(rank(t)) - static_cast<int>(rank(s));
+   int f = static_cast<int>(file(t)) - static_cast<int>(file(s));
+   if ((r == 0 && f == 0) || (r != 0 && f != 0 && r != f && r != -f))
+      return false;
+   dr = (r > 0) - (r < 0);
+   df = (f > 0) - (f < 0);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// True if every square strictly between s and t, stepping by (dr, df), is
+// empty or is the one being vacated.
+bool clearBetween (BitBoard const& b, Square s, Square t, int dr, int df, Square vacated) {
+   int r = rank(s) + dr;
+   int f = file(s) + df;
+   Square x;
+   while ((x = (r << 3) + f) != t) {
+      if (x != vacated && isPiece(b.get(x)))
+         return false;
+      r += dr;
+      f += df;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool slidesAlong (Piece p, int dr, int df) {
+   bool diagonal = dr != 0 && df != 0;
+   if (p == PC::q0 || p == PC::q1) return true;
+   if (p == PC::b0 || p == PC::b1) return diagonal;
+   if (p == PC::r0 || p == PC::r1) return !diagonal;
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// Whether piece p standing on s attacks k, treating vacated as empty.
+bool attacks (BitBoard const& b, Piece p, Square s, Square k, Square vacated) {
+   int r = static_cast<int>(rank(k)) - static_cast<int>(rank(s));
+   int f = static_cast<int>(file(k)) - static_cast<int>(file(s));
+   if (isPawn(p))
+      return (f == 1 || f == -1) && r == (p == PC::p0 ? 1 : -1);
+   if (isKnight(p))
+      return r * r + f * f == 5;
+   if (isKing(p))
+      return r * r <= 1 && f * f <= 1;
+   int dr, df;
+   return direction(s, k, dr, df) && slidesAlong(p, dr, df) && clearBetween(b, s, k, dr, df, vacated);
+}
+
+//------------------------------------------------------------------------------
+// True if s is all that stands between king and a slider of the given colour
+// aimed at it; (dr, df) is set to the direction from the king to s.
+bool screens (BitBoard const& b, Square king, Square s, bool lightSlider, int& dr, int& df) {
+   if (king == 64 || !direction(king, s, dr, df) || !clearBetween(b, king, s, dr, df, 64))
+      return false;
+   int r = rank(s) + dr;
+   int f = file(s) + df;
+   for ( ; 0 <= r && r < 8 && 0 <= f && f < 8; r += dr, f += df) {
+      Piece p = b.get((r << 3) + f);
+      if (isPiece(p))
+         return (lightSlider ? isLightPiece(p) : isDarkPiece(p)) && slidesAlong(p, dr, df);
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// What a side needs to know to find its checks against the enemy king.
+struct CheckTarget {
+   BitBoard const* b;
+   bool light;
+   Square king;   // 64 if there is none
+
+   // captures need no target, so looking for the king is left to find()
+   CheckTarget (Board const& board):
+      b(&board.bitboard()), light(board.pathDependence().lightMove()), king(64) {}
+   void find () {
+      Piece enemyKing = light ? PC::k1 : PC::k0;
+      for (king = 0; king < 64 && b->get(king) != enemyKing; ++king)
+         ;
+   }
+
+   // If a piece leaving s would uncover a friendly slider aimed at the king,
+   // sets (dr, df) to the direction from the king to s.
+   bool uncovers (Square s, int& dr, int& df) const {
+      return screens(*b, king, s, light, dr, df);
+   }
+
+   // uncovered says whether src uncovers a check along (dr, df)
+   bool check (Board const& board, Move const& m, bool uncovered, int dr, int df) const {
+      if (king == 64)
+         return false;
+      if (m.isEnPassant() || m.isCastle()) {
+         Board child;
+         board.realize(m, child);
+         PathIndependentArbiter arbiter;
+         return arbiter.isInCheck(child.bitboard(), !light);
+      }
+      int kr, kf;
+      if (uncovered && !(direction(king, m.dst, kr, kf) && kr == dr && kf == df))
+         return true;
+      Piece p = m.isPromotion() ? m.promotion(light) : b->get(m.src);
+      return attacks(*b, p, m.dst, king, m.src);
+   }
+};
+
+//------------------------------------------------------------------------------
+// The mover's king, or 64 if it has none.
+Square findKing (BitBoard const& b, bool light) {
+   Piece king = light ? PC::k0 : PC::k1;
+   Square s = 0;
+   while (s < 64 && b.get(s) != king)
+      ++s;
+   return s;
+}
+
+//------------------------------------------------------------------------------
+// Whether m leaves the mover's king (on king before the move) safe.
+bool isSafe (Board const& b, Move const& m, Square king, PathIndependentArbiter& arbiter) {
+   if (king == 64)
+      return true;
+   Board child;
+   b.realize(m, child);
+   bool light = b.pathDependence().lightMove();
+   if (m.src == king)
+      return !arbiter.isThreatened(child.bitboard(), m.dst, light);
+   return !arbiter.isThreatened(child.bitboard(), king, light);
+}
+
+//------------------------------------------------------------------------------
+// Whether the piece on src has a move that leaves the king safe.
+bool hasSafeMove (Board const& b, Generator& gen, Square src, Square king,
+                  PathIndependentArbiter& arbiter) {
+   for (gen.setSource(src); gen.valid(); ++gen) {
+      if (isSafe(b, gen.move(), king, arbiter))
+         return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// The search treats under-promotions that don't capture as quiet.
+inline bool isTactical (BitBoard const& b, Move const& m) {
+   return m.isEnPassant() || m.kind == Move::promoteQueen
+       || (m.isSimple() && isPiece(b.get(m.dst)));
+}
+
+//------------------------------------------------------------------------------
+// Walks the moves as Generator would, keeping the ones the mode asks for.
+enum Subset { captures, quietChecks, checks };
+
+void generateSubset (Board const& b, MoveList& list, Subset subset) {
+   list.clear();
+   BitBoard const& bb = b.bitboard();
+   PathDependence const& pd = b.pathDependence();
+   SpecialMoves const& sm = b.specialMoves();
+   bool light = pd.lightMove();
+   CheckTarget target(b);
+   if (subset != captures) {
+      target.find();
+      if (target.king == 64)
+         return;
+   }
+
+   PathIndependentGen gen;
+   gen.setBoard(bb);
+   PieceItr itr(bb, light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      Square src = itr.square();
+      Piece p = itr.piece();
+      int dr = 0;
+      int df = 0;
+      bool uncovered = subset != captures && target.uncovers(src, dr, df);
+
+      for (gen.setSource(src); gen.valid(); ++gen) {
+         Square dst = gen.dst();
+         bool capture = gen.isCapture();
+         if (subset == captures && !capture && !(isPawn(p) && (rank(dst) == 0 || rank(dst) == 7)))
+            continue;
+         unsigned kind = Move::basic;
+         unsigned last = Move::basic;
+         if (isPawn(p) && (rank(dst) == 0 || rank(dst) == 7)) {
+            kind = Move::promoteQueen;
+            last = Move::promoteKnight;
+         }
+         for (unsigned k = kind; ; --k) {
+            Move m(src, dst, k);
+            bool keep = subset == captures ? isTactical(bb, m)
+                      : (subset == checks || !isTactical(bb, m)) && target.check(b, m, uncovered, dr, df);
+            if (keep)
+               list.push(m);
+            if (k == last)
+               break;
+         }
+      }
+
+      // special moves, in Generator's order
+      if (isPawn(p) && pd.pawnAdvanced2()) {
+         Square to = (light ? 40 : 16) + pd.pawnFile();
+         if (sm.canEnPassantLeft() && src == (light ? 31 : 23) + pd.pawnFile()) {
+            Move m(src, to, Move::epLeft);
+            if (subset == captures || (subset == checks && target.check(b, m, uncovered, dr, df)))
+               list.push(m);
+         }
+         if (sm.canEnPassantRight() && src == (light ? 33 : 25) + pd.pawnFile()) {
+            Move m(src, to, Move::epRight);
+            if (subset == captures || (subset == checks && target.check(b, m, uncovered, dr, df)))
+               list.push(m);
+         }
+      }
+      if (isKing(p) && subset != captures) {
+         if (sm.canCastleShort()) {
+            Move m = light ? Move(4, 6, Move::castleShort) : Move(60, 62, Move::castleShort);
+            if (target.check(b, m, false, 0, 0))
+               list.push(m);
+         }
+         if (sm.canCastleLong()) {
+            Move m = light ? Move(4, 2, Move::castleLong) : Move(60, 58, Move::castleLong);
+            if (target.check(b, m, false, 0, 0))
+               list.push(m);
+         }
+      }
+   }
+}
+
+}
+
+//------------------------------------------------------------------------------
+void generatePseudoLegalMoves (Board const& b, MoveList& list) {
+   list.clear();
+   Generator gen;
+   gen.setBoard(b);
+   bool light = b.pathDependence().lightMove();
+   PieceItr itr(b.bitboard(), light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      for (gen.setSource(itr.square()); gen.valid(); ++gen)
+         list.push(gen.move());
+   }
+}
+
+//------------------------------------------------------------------------------
+// As hasLegalMove: out of check, the moves of unpinned pieces (en passant
+// aside) are legal as generated, and only the rest are realized.
+void generateLegalMoves (Board const& b, MoveList& list) {
+   list.clear();
+   BitBoard const& bb = b.bitboard();
+   bool light = b.pathDependence().lightMove();
+   PathIndependentArbiter arbiter;
+   Square king = findKing(bb, light);
+   bool inCheck = king != 64 && arbiter.isThreatened(bb, king, light);
+
+   Generator gen;
+   gen.setBoard(b);
+   PieceItr itr(bb, light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      Square src = itr.square();
+      int dr, df;
+      bool free = !inCheck && src != king && !screens(bb, king, src, !light, dr, df);
+      for (gen.setSource(src); gen.valid(); ++gen) {
+         Move m = gen.move();
+         if ((free && !m.isEnPassant()) || isSafe(b, m, king, arbiter))
+            list.push(m);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Out of check, a move by a piece that isn't pinned can't expose the king
+// (en passant aside, since it empties two squares of the king's rank), so the
+// first such move is taken on sight. Only the king, pinned pieces and en
+// passant are realized, and the king goes first when it is in check.
+bool hasLegalMove (Board const& b) {
+   BitBoard const& bb = b.bitboard();
+   bool light = b.pathDependence().lightMove();
+   PathIndependentArbiter arbiter;
+   Square king = findKing(bb, light);
+   bool inCheck = king != 64 && arbiter.isThreatened(bb, king, light);
+
+   Generator gen;
+   gen.setBoard(b);
+   if (inCheck && hasSafeMove(b, gen, king, king, arbiter))
+      return true;
+
+   unsigned long long deferred = 0;
+   PieceItr itr(bb, light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      Square src = itr.square();
+      int dr, df;
+      if (src == king)
+         continue;
+      if (inCheck || screens(bb, king, src, !light, dr, df)) {
+         deferred |= 1ull << src;
+         continue;
+      }
+      for (gen.setSource(src); gen.valid(); ++gen) {
+         Move m = gen.move();
+         if (!m.isEnPassant() || isSafe(b, m, king, arbiter))
+            return true;
+      }
+   }
+
+   if (!inCheck && king != 64 && hasSafeMove(b, gen, king, king, arbiter))
+      return true;
+   for (Square s = 0; s < 64; ++s) {
+      if ((deferred >> s & 1) && hasSafeMove(b, gen, s, king, arbiter))
+         return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+bool isCheckmate (Board const& b) {
+   bool light = b.pathDependence().lightMove();
+   Square king = findKing(b.bitboard(), light);
+   PathIndependentArbiter arbiter;
+   return king != 64 && arbiter.isThreatened(b.bitboard(), king, light) && !hasLegalMove(b);
+}
+
+//------------------------------------------------------------------------------
+bool isStalemate (Board const& b) {
+   bool light = b.pathDependence().lightMove();
+   Square king = findKing(b.bitboard(), light);
+   PathIndependentArbiter arbiter;
+   return !(king != 64 && arbiter.isThreatened(b.bitboard(), king, light)) && !hasLegalMove(b);
+}
+
+//------------------------------------------------------------------------------
+void generateCaptures (Board const& b, MoveList& list) {
+   generateSubset(b, list, captures);
+}
+
+//------------------------------------------------------------------------------
+void generateQuietChecks (Board const& b, MoveList& list) {
+   generateSubset(b, list, quietChecks);
+}
+
+//------------------------------------------------------------------------------
+void generateChecks (Board const& b, MoveList& list) {
+   generateSubset(b, list, checks);
+}
+
+//------------------------------------------------------------------------------
+bool givesCheck (Board const& b, Move const& m) {
+   CheckTarget target(b);
+   target.find();
+   int dr = 0;
+   int df = 0;
+   bool uncovered = target.uncovers(m.src, dr, df);
+   return target.check(b, m, uncovered, dr, df);
+}
@@ -8,6 +8,7 @@
 
 #include <vector>
 #include "HashFunctions.h"
+#include "Counters.h"
 
 
 //==============================================================================
@@ -102,6 +103,21 @@ inline unsigned rank (Square s) { return s >> 3; }
 inline unsigned file (Square s) { return s & 0x7; }
 
 
+//==============================================================================
+// Zobrist Keys
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// 64 bit keys that are updated incrementally by xoring in and out one random
+// number per (piece, square). Currently only pawns are keyed this way.
+typedef unsigned long long HashKey;
+
+namespace Zobrist {
+   extern HashKey pawnKeys[2][64];
+   inline HashKey pawn (Piece p, Square s) { return pawnKeys[p == PC::p0 ? 0 : 1][s]; }
+}
+
+
 //==============================================================================
 // BitBoard
 //==============================================================================
@@ -120,6 +136,10 @@ public:
    Piece get (Square i) const;
    void clear () { memset(word, (PC::c0 | (PC::c0 << 4)), 32); }
    unsigned hash () const { return murmurhash(word, 8, 0xdefceedu); }
+   unsigned hash (unsigned seed) const { return murmurhash(word, 8, seed); }
+   // the raw nibbles, two squares per byte (for compact storage)
+   unsigned const* words () const { return word; }
+   void setWords (unsigned const* w) { memcpy(word, w, sizeof(unsigned) * 8); }
 
    void move (Square src, Square dst) { set(dst, get(src)); set(src, PC::c0); }
    void lightCastleShort ();
@@ -310,7 +330,12 @@ public:
    inline void setSource (Square src);
 
    bool valid () const { return gen.valid(); }
-   void operator++ () { ++gen; dispatch(); }
+   // a pending jump (after a capture) skips the rest of the direction
+   void operator++ () {
+      if (jump) { gen.nextMotion(); jump = false; }
+      else ++gen;
+      dispatch();
+   }
    void finish () { gen.finish(); }
 
    BitBoard const* board () const { return b; }
@@ -418,9 +443,14 @@ private:
    // Otherwise it should be 0.
    unsigned _pawnFile;
 
+   // moves since the last capture or pawn move, counted in plies
+   unsigned _halfmoveClock;
+   // starts at 1 and goes up after each of dark's moves
+   unsigned _fullmoveNumber;
+
 public:
    PathDependence () {}
-   void newGame () { flags = 0x1; _pawnFile = 0; }
+   void newGame () { flags = 0x1; _pawnFile = 0; _halfmoveClock = 0; _fullmoveNumber = 1; }
 
    // getters
    bool lightMove     () const { return flags & 0x1; }
@@ -432,10 +462,16 @@ public:
    bool darkRook0     () const { return flags & 0x40; }
    bool darkRook7     () const { return flags & 0x80; }
    unsigned pawnFile  () const { return _pawnFile; }
+   unsigned halfmoveClock  () const { return _halfmoveClock; }
+   unsigned fullmoveNumber () const { return _fullmoveNumber; }
+   // all the flag bits at once (for compact storage)
+   unsigned packedFlags () const { return flags; }
 
    // setters
    void swapTurn        () { flags ^= 0x1; }
    void clearPawnState  () { flags &= ~0x2; _pawnFile = 0; }
+   // gives the move to the other side without moving anything (null move)
+   void pass            () { swapTurn(); clearPawnState(); }
    void pawnAdvancedOnFile (unsigned pawnFile) { flags |= 0x2; _pawnFile = pawnFile; }
    void lightKingMoved  () { flags |= 0x4; }
    void lightRook0Moved () { flags |= 0x8; }
@@ -443,6 +479,17 @@ public:
    void darkKingMoved   () { flags |= 0x20; }
    void darkRook0Moved  () { flags |= 0x40; }
    void darkRook7Moved  () { flags |= 0x80; }
+   void setPackedFlags (unsigned f, unsigned pawnFile) {
+      flags = f; _pawnFile = (f & 0x2) ? pawnFile : 0;
+   }
+   void setClocks (unsigned halfmoves, unsigned fullmoves) {
+      _halfmoveClock = halfmoves; _fullmoveNumber = fullmoves;
+   }
+   // called once per move: reset says whether it was a capture or pawn move
+   void advanceClocks (bool reset) {
+      _halfmoveClock = reset ? 0 : _halfmoveClock + 1;
+      if (!lightMove()) ++_fullmoveNumber;
+   }
 };
 
 
@@ -478,6 +525,76 @@ public:
 };
 
 
+//==============================================================================
+// Move
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// A compact description of a single move, independent of any Generator.
+/*
+ * For basic moves src and dst are the squares the piece moves between.
+ * For en passant captures they are the capturing pawn's source and destination,
+ * and for castling they are the king's source and destination.
+ */
+struct Move {
+   unsigned char src;
+   unsigned char dst;
+   unsigned char kind;
+
+   static const unsigned basic       = 0;
+   static const unsigned epLeft      = 1;
+   static const unsigned epRight     = 2;
+   static const unsigned castleShort = 3;
+   static const unsigned castleLong  = 4;
+   // pawn moves to the last rank
+   static const unsigned promoteKnight = 5;
+   static const unsigned promoteBishop = 6;
+   static const unsigned promoteRook   = 7;
+   static const unsigned promoteQueen  = 8;
+   static const unsigned none        = 15;
+
+   Move (): src(0), dst(0), kind(none) {}
+   Move (Square s, Square d, unsigned k): src(s), dst(d), kind(k) {}
+
+   bool valid   () const { return kind != none; }
+   bool isBasic () const { return kind == basic; }
+   bool isEnPassant () const { return kind == epLeft || kind == epRight; }
+   bool isCastle    () const { return kind == castleShort || kind == castleLong; }
+   bool isPromotion () const { return promoteKnight <= kind && kind <= promoteQueen; }
+   // moves a piece from src to dst, possibly capturing on dst
+   bool isSimple    () const { return kind == basic || isPromotion(); }
+   // the piece a pawn of the given color turns into
+   Piece promotion (bool light) const {
+      return (light ? PC::n0 : PC::n1) + (kind - promoteKnight);
+   }
+   bool operator== (Move const& m) const {
+      return src == m.src && dst == m.dst && kind == m.kind;
+   }
+   bool operator!= (Move const& m) const { return !operator==(m); }
+
+   // writes the move in coordinate notation (ex, "e2e4", "e7e8q") and returns the end
+   char* writeCoordinates (char* out) const;
+
+   // packs the move into 16 bits (for transposition tables and the like)
+   unsigned short pack () const { return src | (dst << 6) | (kind << 12); }
+   static Move unpack (unsigned short p) { return Move(p & 0x3f, (p >> 6) & 0x3f, p >> 12); }
+};
+
+//------------------------------------------------------------------------------
+// A fixed capacity list of moves, so generating moves never allocates.
+struct MoveList {
+   static const unsigned capacity = 320;
+   Move move[capacity];
+   unsigned size;
+
+   MoveList (): size(0) {}
+   void clear () { size = 0; }
+   void push (Move const& m) { move[size++] = m; }
+   Move const& operator[] (unsigned i) const { return move[i]; }
+   Move& operator[] (unsigned i) { return move[i]; }
+};
+
+
 //==============================================================================
 // Board
 //==============================================================================
@@ -493,6 +610,8 @@ public:
    Square code[4];
    PathDependence pd;
    SpecialMoves sm; 
+   // Zobrist key of the pawn placement only, maintained by realize
+   HashKey pawnKey;
 
 public:
    Board () {}
@@ -500,17 +619,25 @@ public:
    void testSpecialMoves ();
    void setupNewGame ();
    void realize (Generator const& generator, Board& child) const;
+   void realize (Move const& move, Board& child) const;
+   // the child is this position with the other side to move (null move)
+   void realizeNull (Board& child) const;
 
    BitBoard const& bitboard () const { return b; }
    PathDependence const& pathDependence () const { return pd; }
    SpecialMoves const& specialMoves () const { return sm; }
 
 public:
-   void updatePDBasicMove (Generator const& gen);
+   void updatePDBasicMove (Move const& move, Piece p);
+   void updatePDCapture (Square dst);
    inline void clearHashState ();
    void writeHashState ();
    void writeEnPassantFile ();
    inline void findCodes ();
+   void computePawnKey ();
+   // derives the special moves, hash state and pawn key after b and pd have
+   // been set directly (ex, by a FEN reader)
+   void finishSetup ();
 };
 
 //------------------------------------------------------------------------------
@@ -545,6 +672,8 @@ private:
    // 0: en passant capture left, 1: en passant capture right, 2: O-O, 3: O-O-O, 4: done
    // will later add states for forced draws (threefold repetition, 50 move rule)
    int _state; 
+   // for pawn moves to the last rank: 0 queen, 1 rook, 2 bishop, 3 knight
+   int _promotion;
 
 public:
    Generator () {}
@@ -567,6 +696,9 @@ public:
    Piece  dstPiece () const { return _gen.dstPiece(); }
    bool pawnMoveIsAdvance2 () const { return _gen.pawnMoveIsAdvance2(); }
    bool isCapture  () const { return _gen.isCapture(); }
+   bool moveIsPromotion () const {
+      return _gen.valid() && isPawn(srcPiece()) && (rank(dst()) == 0 || rank(dst()) == 7);
+   }
 
    bool specialMoveIsEPLeft      () const { return _state == 0; }
    bool specialMoveIsEPRight     () const { return _state == 1; }
@@ -579,6 +711,9 @@ public:
    void jumpToCastleShort () { _gen.finish(); _state = 2; }
    void jumpToCastleLong  () { _gen.finish(); _state = 3; }
 
+   // the move the generator currently points at
+   Move move () const;
+
 private:
    void checkSpecialMoves ();
 };
@@ -587,13 +722,20 @@ private:
 void Generator::setSource (Square src) {
    _gen.setSource(src);
    _state = 0;
+   _promotion = 0;
    if (!_gen.valid())
       checkSpecialMoves();
 }
 
 //------------------------------------------------------------------------------
 void Generator::operator++ () {
+   COUNT(generatorSteps);
    if (_gen.valid()) {
+      if (moveIsPromotion() && _promotion < 3) {
+         ++_promotion;
+         return;
+      }
+      _promotion = 0;
       ++_gen;
       if (_gen.valid())
          return;
@@ -613,6 +755,34 @@ class Arbiter {
    bool putsOrLeavesInCheck (Board const& b, Generator const& gen);
 };
 
+//------------------------------------------------------------------------------
+// Fills list with every move of the side to move, in Generator order
+// (source square, then MovementGenerator state, then special moves).
+// Pseudo legal moves may leave the mover's king in check; legal moves may not.
+void generatePseudoLegalMoves (Board const& b, MoveList& list);
+void generateLegalMoves (Board const& b, MoveList& list);
+
+// Tactical subsets of the pseudo legal moves, in the same order, for searches
+// that would otherwise generate everything and throw most of it away.
+// Captures are every capture (promoting to any piece), en passant, and pawn
+// pushes that promote to a queen. Checks are found from the enemy king's
+// square: the moved piece attacking it from dst (direct), or src having
+// blocked a friendly bishop, rook or queen (discovered); only en passant and
+// castling are realized to be sure.
+void generateCaptures (Board const& b, MoveList& list);
+// moves that give check and aren't captures (as above)
+void generateQuietChecks (Board const& b, MoveList& list);
+// every move that gives check, captures included
+void generateChecks (Board const& b, MoveList& list);
+bool givesCheck (Board const& b, Move const& m);
+
+// Whether the side to move has a legal move, stopping at the first one found.
+// Cheap enough for every search node: out of check, most positions are
+// settled by the first move of an unpinned piece, with nothing realized.
+bool hasLegalMove (Board const& b);
+bool isCheckmate (Board const& b);
+bool isStalemate (Board const& b);
+
 
 //==============================================================================
 // Chess Game
@@ -621,6 +791,8 @@ class Arbiter {
 class Game {
 private:
    std::vector<Board> boards;
+   // moves[i] leads from boards[i] to boards[i + 1]
+   std::vector<Move> moves;
 
 public:
    Game () {
@@ -628,10 +800,31 @@ public:
       boards[0].setupNewGame();
    }
    Board const& currentBoard () const { return boards.back(); }
+   // moves played since the starting position, and the position after each
+   unsigned plies () const { return boards.size() - 1; }
+   Board const& board (unsigned ply) const { return boards[ply]; }
+   Move const& moveAt (unsigned ply) const { return moves[ply]; }
+   void newGame () {
+      boards.clear();
+      moves.clear();
+      boards.push_back(Board());
+      boards[0].setupNewGame();
+   }
+   void setPosition (Board const& b) {
+      boards.clear();
+      moves.clear();
+      boards.push_back(Board());
+      boards[0] = b;
+   }
    void move (Generator const& gen) {
-      Board const& current = boards.back();
       boards.push_back(Board());
-      current.realize(gen, boards.back());
+      boards[boards.size() - 2].realize(gen, boards.back());
+      moves.push_back(gen.move());
+   }
+   void move (Move const& m) {
+      boards.push_back(Board());
+      boards[boards.size() - 2].realize(m, boards.back());
+      moves.push_back(m);
    }
 };
 
@@ -0,0 +1,145 @@
+//==============================================================================
+// Counters.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Counters.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+unsigned const cacheLine = 64;
+
+// every block ever attached; never freed, since totals may be asked for after
+// a thread is gone
+std::mutex blocksMutex;
+std::vector<Counters::Totals*> blocks;
+
+//------------------------------------------------------------------------------
+// The last ply with any nodes, plus one.
+unsigned plies (Counters::Totals const& t) {
+   unsigned n = Counters::maxPly;
+   while (n > 0 && t.plyNodes[n - 1] == 0)
+      --n;
+   return n;
+}
+
+}
+
+
+//==============================================================================
+// Hot Path Counters
+//==============================================================================
+
+thread_local Counters::Totals* Counters::current = 0;
+
+//------------------------------------------------------------------------------
+// Rounded up to whole cache lines, so the next allocation can't share one.
+Counters::Totals& Counters::attach () {
+   void* p = 0;
+   unsigned size = (sizeof(Totals) + cacheLine - 1) / cacheLine * cacheLine;
+   if (posix_memalign(&p, cacheLine, size) != 0)
+      std::abort();
+   memset(p, 0, size);
+   current = static_cast<Totals*>(p);
+   std::lock_guard<std::mutex> lock(blocksMutex);
+   blocks.push_back(current);
+   return *current;
+}
+
+//------------------------------------------------------------------------------
+bool Counters::enabled () {
+#ifdef COUNTERS
+   return true;
+#else
+   return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+Counters::Totals Counters::totals () {
+   Totals t;
+   memset(&t, 0, sizeof(t));
+   std::lock_guard<std::mutex> lock(blocksMutex);
+   for (unsigned i=0; i<blocks.size(); ++i) {
+      for (unsigned c=0; c<counterCount; ++c)
+         t.count[c] += blocks[i]->count[c];
+      for (unsigned p=0; p<maxPly; ++p)
+         t.plyNodes[p] += blocks[i]->plyNodes[p];
+   }
+   return t;
+}
+
+//------------------------------------------------------------------------------
+// Only exact while no thread is counting.
+void Counters::reset () {
+   std::lock_guard<std::mutex> lock(blocksMutex);
+   for (unsigned i=0; i<blocks.size(); ++i)
+      memset(blocks[i], 0, sizeof(Totals));
+}
+
+//------------------------------------------------------------------------------
+char const* Counters::name (Counter c) {
+   static char const* const names[counterCount] = {
+      "realize", "isInCheck", "isThreatened", "testSpecialMoves", "generatorSteps",
+      "hashProbes", "hashHits", "hashCutoffs", "betaCutoffs", "nodes"
+   };
+   return names[c];
+}
+
+//------------------------------------------------------------------------------
+std::string Counters::text (Totals const& t) {
+   std::string s;
+   char line[64];
+   for (unsigned c=0; c<counterCount; ++c) {
+      std::snprintf(line, sizeof(line), "%-18s %llu\n", name(static_cast<Counter>(c)), t.count[c]);
+      s += line;
+   }
+   for (unsigned p=0; p<plies(t); ++p) {
+      std::snprintf(line, sizeof(line), "nodes at ply %-5u %llu\n", p, t.plyNodes[p]);
+      s += line;
+   }
+   return s;
+}
+
+//------------------------------------------------------------------------------
+std::string Counters::json (Totals const& t) {
+   std::string s = "{";
+   char field[64];
+   for (unsigned c=0; c<counterCount; ++c) {
+      std::snprintf(field, sizeof(field), "\"%s\": %llu, ", name(static_cast<Counter>(c)), t.count[c]);
+      s += field;
+   }
+   s += "\"plyNodes\": [";
+   for (unsigned p=0; p<plies(t); ++p) {
+      std::snprintf(field, sizeof(field), p ? ", %llu" : "%llu", t.plyNodes[p]);
+      s += field;
+   }
+   return s + "]}";
+}
+
+//------------------------------------------------------------------------------
+std::string Counters::info (Totals const& t) {
+   std::string s = "info string counters";
+   char field[64];
+   for (unsigned c=0; c<counterCount; ++c) {
+      std::snprintf(field, sizeof(field), " %s %llu", name(static_cast<Counter>(c)), t.count[c]);
+      s += field;
+   }
+   s += " plyNodes";
+   for (unsigned p=0; p<plies(t); ++p) {
+      std::snprintf(field, sizeof(field), " %llu", t.plyNodes[p]);
+      s += field;
+   }
+   return s;
+}
@@ -0,0 +1,79 @@
+//==============================================================================
+// Counters.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <string>
+
+
+//==============================================================================
+// Hot Path Counters
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Counts of how often the engine's inner loops run.
+/*
+ * Counting is compiled in only when COUNTERS is defined (make COUNTERS=1);
+ * otherwise COUNT and COUNT_PLY expand to nothing and cost nothing.
+ *
+ * Each thread counts into its own block, allocated on the thread's first count
+ * and aligned to cache lines so that threads searching side by side never
+ * write to the same line. Blocks outlive their threads, so totals() (which
+ * sums every block, racing harmlessly with threads still counting) includes
+ * threads that have finished.
+ */
+namespace Counters {
+   enum Counter {
+      realize,
+      isInCheck,
+      isThreatened,
+      testSpecialMoves,
+      generatorSteps,
+      hashProbes,
+      hashHits,
+      hashCutoffs,
+      betaCutoffs,
+      nodes,
+      counterCount
+   };
+   static const unsigned maxPly = 64;
+
+   // one thread's counts, or everyone's
+   struct Totals {
+      unsigned long long count[counterCount];
+      // nodes by distance from the root
+      unsigned long long plyNodes[maxPly];
+   };
+
+   // the calling thread's block, allocated by attach on its first count
+   extern thread_local Totals* current;
+   Totals& attach ();
+   inline Totals& local () { return current ? *current : attach(); }
+
+   // true if counting was compiled in
+   bool enabled ();
+   Totals totals ();
+   void reset ();
+   char const* name (Counter c);
+
+   // one counter per line, then nodes by ply
+   std::string text (Totals const& t);
+   std::string json (Totals const& t);
+   // a UCI "info string" line, without the trailing newline
+   std::string info (Totals const& t);
+}
+
+#ifdef COUNTERS
+   #define COUNT(counter) (++Counters::local().count[Counters::counter])
+   #define COUNT_PLY(ply) \
+      (++Counters::local().plyNodes[(ply) < Counters::maxPly ? (ply) : Counters::maxPly - 1])
+#else
+   #define COUNT(counter) ((void)0)
+   #define COUNT_PLY(ply) ((void)0)
+#endif
+
+
+#endif
@@ -0,0 +1,234 @@
+//==============================================================================
+// Evaluation.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Evaluation.h"
+
+
+//==============================================================================
+// Piece Square Tables
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Tables are written from light's point of view with a1 in the bottom left,
+// so they read like a diagram. Dark pieces look up the vertically mirrored square.
+namespace {
+
+const int pawnTable[64] = {
+     0,   0,   0,   0,   0,   0,   0,   0,
+    50,  50,  50,  50,  50,  50,  50,  50,
+    10,  10,  20,  30,  30,  20,  10,  10,
+     5,   5,  10,  25,  25,  10,   5,   5,
+     0,   0,   0,  20,  20,   0,   0,   0,
+     5,  -5, -10,   0,   0, -10,  -5,   5,
+     5,  10,  10, -20, -20,  10,  10,   5,
+     0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int knightTable[64] = {
+   -50, -40, -30, -30, -30, -30, -40, -50,
+   -40, -20,   0,   0,   0,   0, -20, -40,
+   -30,   0,  10,  15,  15,  10,   0, -30,
+   -30,   5,  15,  20,  20,  15,   5, -30,
+   -30,   0,  15,  20,  20,  15,   0, -30,
+   -30,   5,  10,  15,  15,  10,   5, -30,
+   -40, -20,   0,   5,   5,   0, -20, -40,
+   -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const int bishopTable[64] = {
+   -20, -10, -10, -10, -10, -10, -10, -20,
+   -10,   0,   0,   0,   0,   0,   0, -10,
+   -10,   0,   5,  10,  10,   5,   0, -10,
+   -10,   5,   5,  10,  10,   5,   5, -10,
+   -10,   0,  10,  10,  10,  10,   0, -10,
+   -10,  10,  10,  10,  10,  10,  10, -10,
+   -10,   5,   0,   0,   0,   0,   5, -10,
+   -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const int rookTable[64] = {
+     0,   0,   0,   0,   0,   0,   0,   0,
+     5,  10,  10,  10,  10,  10,  10,   5,
+    -5,   0,   0,   0,   0,   0,   0,  -5,
+    -5,   0,   0,   0,   0,   0,   0,  -5,
+    -5,   0,   0,   0,   0,   0,   0,  -5,
+    -5,   0,   0,   0,   0,   0,   0,  -5,
+    -5,   0,   0,   0,   0,   0,   0,  -5,
+     0,   0,   0,   5,   5,   0,   0,   0
+};
+
+const int queenTable[64] = {
+   -20, -10, -10,  -5,  -5, -10, -10, -20,
+   -10,   0,   0,   0,   0,   0,   0, -10,
+   -10,   0,   5,   5,   5,   5,   0, -10,
+    -5,   0,   5,   5,   5,   5,   0,  -5,
+     0,   0,   5,   5,   5,   5,   0,  -5,
+   -10,   5,   5,   5,   5,   5,   0, -10,
+   -10,   0,   5,   0,   0,   0,   0, -10,
+   -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+const int kingTable[64] = {
+   -30, -40, -40, -50, -50, -40, -40, -30,
+   -30, -40, -40, -50, -50, -40, -40, -30,
+   -30, -40, -40, -50, -50, -40, -40, -30,
+   -30, -40, -40, -50, -50, -40, -40, -30,
+   -20, -30, -30, -40, -40, -30, -30, -20,
+   -10, -20, -20, -20, -20, -20, -20, -10,
+    20,  20,   0,   0,   0,   0,  20,  20,
+    20,  30,  10,   0,   0,  10,  30,  20
+};
+
+// pawn structure terms
+const int doubledPenalty  = 15;
+const int isolatedPenalty = 12;
+// passed pawn bonus by ranks advanced from the pawn's starting rank
+const int passedBonus[8] = { 0, 5, 10, 20, 35, 60, 100, 0 };
+
+//------------------------------------------------------------------------------
+// Maps a square to its index in the diagram-ordered tables above.
+inline unsigned lightIndex (Square s) { return s ^ 56; }
+inline unsigned darkIndex  (Square s) { return s; }
+
+//------------------------------------------------------------------------------
+int tableValue (Piece p, unsigned i) {
+   switch (p) {
+   case PC::p0: case PC::p1: return pawnTable[i];
+   case PC::n0: case PC::n1: return knightTable[i];
+   case PC::b0: case PC::b1: return bishopTable[i];
+   case PC::r0: case PC::r1: return rookTable[i];
+   case PC::q0: case PC::q1: return queenTable[i];
+   case PC::k0: case PC::k1: return kingTable[i];
+   }
+   return 0;
+}
+
+}
+
+
+//==============================================================================
+// PawnHashTable Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void PawnHashTable::resize (unsigned count) {
+   unsigned size = 1;
+   while ((size << 1) <= count)
+      size <<= 1;
+   entries.resize(size);
+   mask = size - 1;
+   clear();
+}
+
+//------------------------------------------------------------------------------
+void PawnHashTable::clear () {
+   for (unsigned i=0; i<entries.size(); ++i) {
+      // no pawn placement hashes to ~0 in practice; an empty board hashes to 0
+      entries[i].key = ~0ull;
+      entries[i].score = 0;
+      entries[i].passed[0] = entries[i].passed[1] = 0;
+   }
+   resetCounters();
+}
+
+//------------------------------------------------------------------------------
+PawnEntry const& PawnHashTable::probe (Board const& b) {
+   ++_probes;
+   PawnEntry& entry = entries[b.pawnKey & mask];
+   if (entry.key == b.pawnKey) {
+      ++_hits;
+      return entry;
+   }
+   entry.key = b.pawnKey;
+   evaluatePawns(b.bitboard(), entry);
+   return entry;
+}
+
+//------------------------------------------------------------------------------
+void PawnHashTable::evaluatePawns (BitBoard const& b, PawnEntry& entry) {
+   // per file: pawn counts, and the least and most advanced ranks (-1 if none)
+   int count[2][8];
+   int minRank[2][8];
+   int maxRank[2][8];
+   for (unsigned f=0; f<8; ++f) {
+      count[0][f] = count[1][f] = 0;
+      minRank[0][f] = minRank[1][f] = -1;
+      maxRank[0][f] = maxRank[1][f] = -1;
+   }
+
+   for (PieceItr itr(b, PieceItr::all_pieces); itr.valid(); ++itr) {
+      if (!isPawn(itr.piece()))
+         continue;
+      int c = itr.piece() == PC::p0 ? 0 : 1;
+      int f = file(itr.square());
+      int r = rank(itr.square());
+      ++count[c][f];
+      if (minRank[c][f] < 0 || r < minRank[c][f]) minRank[c][f] = r;
+      if (r > maxRank[c][f]) maxRank[c][f] = r;
+   }
+
+   int score[2] = { 0, 0 };
+   entry.passed[0] = entry.passed[1] = 0;
+   for (PieceItr itr(b, PieceItr::all_pieces); itr.valid(); ++itr) {
+      if (!isPawn(itr.piece()))
+         continue;
+      int c = itr.piece() == PC::p0 ? 0 : 1;
+      int f = file(itr.square());
+      int r = rank(itr.square());
+
+      bool isolated = (f == 0 || count[c][f-1] == 0) && (f == 7 || count[c][f+1] == 0);
+      if (isolated)
+         score[c] -= isolatedPenalty;
+
+      // passed if no enemy pawn on this or an adjacent file can stop it
+      bool passed = true;
+      for (int g = (f > 0 ? f-1 : 0); g <= (f < 7 ? f+1 : 7); ++g) {
+         if (c == 0 && maxRank[1][g] > r) passed = false;
+         if (c == 1 && minRank[0][g] >= 0 && minRank[0][g] < r) passed = false;
+      }
+      if (passed) {
+         score[c] += passedBonus[c == 0 ? r : 7 - r];
+         entry.passed[c] |= 1ull << itr.square();
+      }
+   }
+
+   for (unsigned f=0; f<8; ++f) {
+      if (count[0][f] > 1) score[0] -= doubledPenalty * (count[0][f] - 1);
+      if (count[1][f] > 1) score[1] -= doubledPenalty * (count[1][f] - 1);
+   }
+
+   entry.score = score[0] - score[1];
+}
+
+
+//==============================================================================
+// Evaluator Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+int Evaluator::pieceValue (Piece p) {
+   switch (p) {
+   case PC::p0: case PC::p1: return 100;
+   case PC::n0: case PC::n1: return 320;
+   case PC::b0: case PC::b1: return 330;
+   case PC::r0: case PC::r1: return 500;
+   case PC::q0: case PC::q1: return 900;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+int Evaluator::evaluate (Board const& b) {
+   int score = 0;
+   for (PieceItr itr(b.bitboard(), PieceItr::all_pieces); itr.valid(); ++itr) {
+      Piece p = itr.piece();
+      if (isLightPiece(p))
+         score += pieceValue(p) + tableValue(p, lightIndex(itr.square()));
+      else
+         score -= pieceValue(p) + tableValue(p, darkIndex(itr.square()));
+   }
+   score += _pawns.probe(b).score;
+   return b.pathDependence().lightMove() ? score : -score;
+}
@@ -0,0 +1,93 @@
+//==============================================================================
+// Evaluation.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef EVALUATION
+#define EVALUATION
+
+#include <vector>
+#include "Chess.h"
+
+
+//==============================================================================
+// Scores
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Scores are in centipawns, from the point of view of the side to move.
+namespace Score {
+   static const int infinity = 32000;
+   static const int mate     = 31000;
+   // any score beyond this bound is a forced mate
+   static const int mateBound = mate - 1000;
+
+   inline int matedIn (unsigned ply) { return -mate + static_cast<int>(ply); }
+   inline int mateIn  (unsigned ply) { return  mate - static_cast<int>(ply); }
+   inline bool isMate (int score) { return score > mateBound || score < -mateBound; }
+}
+
+
+//==============================================================================
+// Pawn Hash Table
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Cached pawn structure evaluation for one pawn placement.
+struct PawnEntry {
+   HashKey key;
+   // doubled, isolated and passed pawn terms, from light's point of view
+   int score;
+   // squares of passed pawns: passed[0] for light, passed[1] for dark (bit i is square i)
+   unsigned long long passed[2];
+};
+
+//------------------------------------------------------------------------------
+// Pawn structure only changes when pawns move or are captured, so most lookups
+// hit. Keyed on Board::pawnKey. Meant to be owned by a single thread.
+class PawnHashTable {
+private:
+   std::vector<PawnEntry> entries;
+   HashKey mask;
+   unsigned long long _probes;
+   unsigned long long _hits;
+
+public:
+   static const unsigned defaultEntries = 1 << 14;
+
+   PawnHashTable () { resize(defaultEntries); }
+   // the number of entries is rounded down to a power of two
+   void resize (unsigned count);
+   void clear ();
+
+   // returns the entry for this pawn placement, evaluating it on a miss
+   PawnEntry const& probe (Board const& b);
+
+   unsigned long long probes () const { return _probes; }
+   unsigned long long hits   () const { return _hits; }
+   double hitRate () const { return _probes ? double(_hits) / _probes : 0.0; }
+   void resetCounters () { _probes = 0; _hits = 0; }
+
+   static void evaluatePawns (BitBoard const& b, PawnEntry& entry);
+};
+
+
+//==============================================================================
+// Evaluator
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Static evaluation of a position: material, piece square tables and pawn structure.
+class Evaluator {
+private:
+   PawnHashTable _pawns;
+
+public:
+   // material value of a piece (kings are worth nothing)
+   static int pieceValue (Piece p);
+
+   int evaluate (Board const& b);
+   PawnHashTable& pawnTable () { return _pawns; }
+};
+
+#endif
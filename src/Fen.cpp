@@ -0,0 +1,331 @@
+//==============================================================================
+// Fen.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Fen.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Piece codes indexed by FEN letter (0 for anything that isn't a piece letter).
+struct LetterTable {
+   Piece piece[128];
+   LetterTable () {
+      memset(piece, 0, sizeof(piece));
+      piece['P'] = PC::p0; piece['N'] = PC::n0; piece['B'] = PC::b0;
+      piece['R'] = PC::r0; piece['Q'] = PC::q0; piece['K'] = PC::k0;
+      piece['p'] = PC::p1; piece['n'] = PC::n1; piece['b'] = PC::b1;
+      piece['r'] = PC::r1; piece['q'] = PC::q1; piece['k'] = PC::k1;
+   }
+} const letters;
+
+// FEN letters indexed by piece code
+char const pieceLetters[] = "....PNBRQKpnbrqk";
+
+//------------------------------------------------------------------------------
+inline char const* skipSpaces (char const* p, char const* end) {
+   while (p < end && (*p == ' ' || *p == '\t'))
+      ++p;
+   return p;
+}
+
+//------------------------------------------------------------------------------
+// Reads an unsigned decimal number. Returns 0 if there are no digits.
+inline char const* readNumber (char const* p, char const* end, unsigned& n) {
+   if (p == end || *p < '0' || *p > '9')
+      return 0;
+   n = 0;
+   while (p < end && '0' <= *p && *p <= '9')
+      n = 10 * n + (*p++ - '0');
+   return p;
+}
+
+//------------------------------------------------------------------------------
+// Reads the placement, side to move, castling and en passant fields into b
+// (without computing any derived state). Returns 0 on failure.
+char const* readFields (char const* p, char const* end, Board& b) {
+   b.b.clear();
+   b.pd.newGame();
+   b.sm.clear();
+
+   // piece placement, from a8 to h1
+   unsigned lightKings = 0;
+   unsigned darkKings  = 0;
+   // the board keeps four empty squares for its hash state (see findCodes), so
+   // more than a full set per side can't be represented
+   unsigned lightPieces = 0;
+   unsigned darkPieces  = 0;
+   int r = 7;
+   int f = 0;
+   p = skipSpaces(p, end);
+   for ( ; p < end && *p != ' '; ++p) {
+      char c = *p;
+      if (c == '/') {
+         if (f != 8 || r == 0)
+            return 0;
+         --r;
+         f = 0;
+      } else if ('1' <= c && c <= '8') {
+         f += c - '0';
+         if (f > 8)
+            return 0;
+      } else {
+         Piece piece = (c & 0x80) ? 0 : letters.piece[static_cast<unsigned>(c)];
+         if (!piece || f > 7)
+            return 0;
+         // pawns can never stand on the first or last rank
+         if (isPawn(piece) && (r == 0 || r == 7))
+            return 0;
+         if (piece == PC::k0) ++lightKings;
+         if (piece == PC::k1) ++darkKings;
+         if (isLightPiece(piece) ? ++lightPieces > 16 : ++darkPieces > 16)
+            return 0;
+         b.b.set((r << 3) + f, piece);
+         ++f;
+      }
+   }
+   if (r != 0 || f != 8 || lightKings != 1 || darkKings != 1)
+      return 0;
+
+   // side to move
+   p = skipSpaces(p, end);
+   if (p == end)
+      return 0;
+   if (*p == 'b')
+      b.pd.swapTurn();
+   else if (*p != 'w')
+      return 0;
+   ++p;
+
+   // castling: rights are lost once the king or the relevant rook has moved
+   p = skipSpaces(p, end);
+   bool K = false, Q = false, k = false, q = false;
+   if (p < end && *p == '-') {
+      ++p;
+   } else {
+      for ( ; p < end && *p != ' '; ++p) {
+         switch (*p) {
+         case 'K': K = true; break;
+         case 'Q': Q = true; break;
+         case 'k': k = true; break;
+         case 'q': q = true; break;
+         default: return 0;
+         }
+      }
+   }
+   // rights the pieces can't back up are dropped rather than rejected
+   if (b.b.get(4) != PC::k0 || b.b.get(7) != PC::r0)  K = false;
+   if (b.b.get(4) != PC::k0 || b.b.get(0) != PC::r0)  Q = false;
+   if (b.b.get(60) != PC::k1 || b.b.get(63) != PC::r1) k = false;
+   if (b.b.get(60) != PC::k1 || b.b.get(56) != PC::r1) q = false;
+   if (!K && !Q) b.pd.lightKingMoved();
+   if (!K)       b.pd.lightRook7Moved();
+   if (!Q)       b.pd.lightRook0Moved();
+   if (!k && !q) b.pd.darkKingMoved();
+   if (!k)       b.pd.darkRook7Moved();
+   if (!q)       b.pd.darkRook0Moved();
+
+   // en passant: the square the pawn skipped
+   p = skipSpaces(p, end);
+   if (p == end)
+      return 0;
+   if (*p == '-') {
+      ++p;
+   } else {
+      if (end - p < 2 || p[0] < 'a' || p[0] > 'h')
+         return 0;
+      unsigned epFile = p[0] - 'a';
+      bool light = b.pd.lightMove();
+      if (p[1] != (light ? '6' : '3'))
+         return 0;
+      // the pawn that advanced must be where it would have landed
+      if (b.b.get((light ? 32 : 24) + epFile) != (light ? PC::p1 : PC::p0))
+         return 0;
+      b.pd.pawnAdvancedOnFile(epFile);
+      p += 2;
+   }
+   return p;
+}
+
+//------------------------------------------------------------------------------
+// Writes the placement, side to move, castling and en passant fields.
+char* writeFields (Board const& b, char* out) {
+   BitBoard const& bb = b.bitboard();
+   PathDependence const& pd = b.pathDependence();
+
+   for (int r = 7; r >= 0; --r) {
+      unsigned empty = 0;
+      for (int f = 0; f < 8; ++f) {
+         Piece p = bb.get((r << 3) + f);
+         if (isPiece(p)) {
+            if (empty)
+               *out++ = '0' + empty;
+            empty = 0;
+            *out++ = pieceLetters[p];
+         } else {
+            ++empty;
+         }
+      }
+      if (empty)
+         *out++ = '0' + empty;
+      if (r)
+         *out++ = '/';
+   }
+
+   *out++ = ' ';
+   *out++ = pd.lightMove() ? 'w' : 'b';
+
+   *out++ = ' ';
+   char* castling = out;
+   bool lightHome = !pd.lightKing() && bb.get(4) == PC::k0;
+   bool darkHome  = !pd.darkKing()  && bb.get(60) == PC::k1;
+   if (lightHome && !pd.lightRook7() && bb.get(7)  == PC::r0) *out++ = 'K';
+   if (lightHome && !pd.lightRook0() && bb.get(0)  == PC::r0) *out++ = 'Q';
+   if (darkHome  && !pd.darkRook7()  && bb.get(63) == PC::r1) *out++ = 'k';
+   if (darkHome  && !pd.darkRook0()  && bb.get(56) == PC::r1) *out++ = 'q';
+   if (out == castling)
+      *out++ = '-';
+
+   *out++ = ' ';
+   if (pd.pawnAdvanced2()) {
+      *out++ = 'a' + pd.pawnFile();
+      *out++ = pd.lightMove() ? '6' : '3';
+   } else {
+      *out++ = '-';
+   }
+   return out;
+}
+
+//------------------------------------------------------------------------------
+char* writeNumber (unsigned n, char* out) {
+   char digits[12];
+   unsigned i = 0;
+   do {
+      digits[i++] = '0' + n % 10;
+      n /= 10;
+   } while (n);
+   while (i)
+      *out++ = digits[--i];
+   return out;
+}
+
+}
+
+
+//==============================================================================
+// FEN
+//==============================================================================
+
+char const* const Fen::startPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+//------------------------------------------------------------------------------
+char const* Fen::read (char const* begin, char const* end, Board& b) {
+   char const* p = readFields(begin, end, b);
+   if (!p)
+      return 0;
+
+   // the clocks are optional (many FENs in the wild leave them off)
+   unsigned halfmoves = 0;
+   unsigned fullmoves = 1;
+   char const* q = readNumber(skipSpaces(p, end), end, halfmoves);
+   if (q) {
+      p = q;
+      q = readNumber(skipSpaces(p, end), end, fullmoves);
+      if (q)
+         p = q;
+   }
+   b.pd.setClocks(halfmoves, fullmoves ? fullmoves : 1);
+
+   b.finishSetup();
+   return p;
+}
+
+//------------------------------------------------------------------------------
+char const* Fen::read (char const* text, Board& b) {
+   return read(text, text + strlen(text), b);
+}
+
+//------------------------------------------------------------------------------
+char const* Fen::readEpd (char const* begin, char const* end, Board& b, char const*& operations) {
+   char const* p = readFields(begin, end, b);
+   if (!p)
+      return 0;
+
+   // EPD may carry the clocks as operations
+   char const* value;
+   unsigned length;
+   unsigned halfmoves = 0;
+   unsigned fullmoves = 1;
+   operations = skipSpaces(p, end);
+   char const* lineEnd = operations;
+   while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+      ++lineEnd;
+   if (findOperation(operations, lineEnd, "hmvc", value, length))
+      readNumber(value, value + length, halfmoves);
+   if (findOperation(operations, lineEnd, "fmvn", value, length))
+      readNumber(value, value + length, fullmoves);
+   b.pd.setClocks(halfmoves, fullmoves ? fullmoves : 1);
+
+   b.finishSetup();
+   return lineEnd;
+}
+
+//------------------------------------------------------------------------------
+char* Fen::write (Board const& b, char* out) {
+   out = writeFields(b, out);
+   *out++ = ' ';
+   out = writeNumber(b.pathDependence().halfmoveClock(), out);
+   *out++ = ' ';
+   out = writeNumber(b.pathDependence().fullmoveNumber(), out);
+   *out = 0;
+   return out;
+}
+
+//------------------------------------------------------------------------------
+char* Fen::writeEpd (Board const& b, char* out) {
+   out = writeFields(b, out);
+   *out = 0;
+   return out;
+}
+
+//------------------------------------------------------------------------------
+bool Fen::findOperation (char const* begin, char const* end, char const* opcode,
+                         char const*& value, unsigned& length) {
+   unsigned opcodeLength = strlen(opcode);
+   char const* p = begin;
+   while (p < end) {
+      p = skipSpaces(p, end);
+      char const* op = p;
+      while (p < end && *p != ' ' && *p != ';')
+         ++p;
+      bool match = static_cast<unsigned>(p - op) == opcodeLength
+                && strncmp(op, opcode, opcodeLength) == 0;
+
+      // operands run to the next ';' that isn't inside a string
+      p = skipSpaces(p, end);
+      char const* operands = p;
+      bool quoted = false;
+      while (p < end && (quoted || *p != ';')) {
+         if (*p == '"')
+            quoted = !quoted;
+         ++p;
+      }
+      if (match) {
+         char const* last = p;
+         while (last > operands && (last[-1] == ' ' || last[-1] == '\t'))
+            --last;
+         value = operands;
+         length = last - operands;
+         return true;
+      }
+      if (p < end)
+         ++p;
+   }
+   return false;
+}
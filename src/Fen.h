@@ -0,0 +1,49 @@
+//==============================================================================
+// Fen.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef FEN
+#define FEN
+
+#include "Chess.h"
+
+
+//==============================================================================
+// FEN and EPD
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Reads and writes Forsyth-Edwards Notation and Extended Position Description.
+/*
+ * Nothing here allocates. Readers take the text as a [begin, end) range (so
+ * they can work straight out of a larger buffer) and return a pointer just past
+ * what they consumed, or 0 if the text is not a valid position.
+ */
+namespace Fen {
+   // longest FEN we ever write, including the terminating 0
+   static const unsigned maxLength = 96;
+
+   // the standard starting position
+   extern char const* const startPosition;
+
+   // Reads the six FEN fields. The two clock fields may be missing.
+   char const* read (char const* begin, char const* end, Board& b);
+   char const* read (char const* text, Board& b);
+
+   // Reads the four EPD position fields. On success operations is set to the
+   // start of the operations (ex, "bm e4; id \"x\";") that follow.
+   char const* readEpd (char const* begin, char const* end, Board& b, char const*& operations);
+
+   // Writes a 0 terminated FEN (or EPD position fields) to out, which must hold
+   // maxLength characters. Returns a pointer to the terminating 0.
+   char* write (Board const& b, char* out);
+   char* writeEpd (Board const& b, char* out);
+
+   // Finds an EPD operation by opcode in [begin, end). On success value and
+   // length describe its operands, without the terminating ';'.
+   bool findOperation (char const* begin, char const* end, char const* opcode,
+                       char const*& value, unsigned& length);
+}
+
+#endif
@@ -4,9 +4,543 @@
 //==============================================================================
 
 #include "GambitInterface.h"
+#include "Fen.h"
+#include "San.h"
+#include "Trace.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 
 
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Finds the next whitespace separated token at or after p.
+// Returns false if there are none left.
+bool nextToken (char const*& p, char const*& token, unsigned& length) {
+   while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+      ++p;
+   if (!*p)
+      return false;
+   token = p;
+   while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+      ++p;
+   length = p - token;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool tokenIs (char const* token, unsigned length, char const* word) {
+   return strlen(word) == length && strncmp(token, word, length) == 0;
+}
+
+//------------------------------------------------------------------------------
+long long tokenValue (char const* token, unsigned length) {
+   char buffer[32];
+   if (length >= sizeof(buffer))
+      length = sizeof(buffer) - 1;
+   memcpy(buffer, token, length);
+   buffer[length] = 0;
+   return atoll(buffer);
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the command (up to its first token) is the given word.
+bool commandIs (std::string const& command, char const* word) {
+   char const* p = command.c_str();
+   char const* token;
+   unsigned length;
+   return nextToken(p, token, length) && tokenIs(token, length, word);
+}
+
+}
+
+
+//==============================================================================
+// AsyncWriter Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+AsyncWriter::AsyncWriter (int fd_): fd(fd_), busy(false), quit(false) {
+   thread = std::thread(&AsyncWriter::run, this);
+}
+
+//------------------------------------------------------------------------------
+AsyncWriter::~AsyncWriter () {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+   }
+   ready.notify_one();
+   thread.join();
+}
+
+//------------------------------------------------------------------------------
+void AsyncWriter::write (char const* text, unsigned length) {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.append(text, length);
+   }
+   ready.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void AsyncWriter::line (std::string const& text) {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending += text;
+      pending += '\n';
+   }
+   ready.notify_one();
+}
+
+//------------------------------------------------------------------------------
+void AsyncWriter::flush () {
+   std::unique_lock<std::mutex> lock(mutex);
+   while (busy || !pending.empty())
+      drained.wait(lock);
+}
+
+//------------------------------------------------------------------------------
+void AsyncWriter::run () {
+   Trace::nameThread("output");
+   std::unique_lock<std::mutex> lock(mutex);
+   while (true) {
+      while (!quit && pending.empty())
+         ready.wait(lock);
+      if (pending.empty()) {
+         // quit, and nothing left to write
+         return;
+      }
+
+      writing.swap(pending);
+      busy = true;
+      lock.unlock();
+
+      Trace::Scope scope("io", "write", writing.size());
+      char const* p = writing.data();
+      size_t left = writing.size();
+      while (left > 0) {
+         ssize_t n = ::write(fd, p, left);
+         if (n <= 0)
+            break;
+         p += n;
+         left -= n;
+      }
+      writing.clear();
+
+      lock.lock();
+      busy = false;
+      drained.notify_all();
+   }
+}
+
+
+//==============================================================================
+// GambitInterface Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+GambitInterface::GambitInterface ():
+   out(1),
+   ownBook(false),
+   bookRandom(millisecondsNow())
+{
+   pool.setObserver(this);
+}
+
+//------------------------------------------------------------------------------
+GambitInterface::~GambitInterface () {
+   pool.stop();
+   if (searchThread.joinable())
+      searchThread.join();
+   if (inputThread.joinable())
+      inputThread.join();
+}
+
 //------------------------------------------------------------------------------
 void GambitInterface::loop () {
+   Trace::nameThread("main");
+   inputThread = std::thread(&GambitInterface::readInput, this);
+   while (execute(nextCommand()))
+      ;
+   finishSearch();
+   out.flush();
 }
 
+//------------------------------------------------------------------------------
+// Runs on the input thread. Time critical commands take effect here.
+void GambitInterface::readInput () {
+   std::string line;
+   Trace::nameThread("input");
+   while (std::getline(std::cin, line)) {
+      if (commandIs(line, "stop")) {
+         Trace::instant("uci", "stop");
+         pool.stop();
+      }
+      else if (commandIs(line, "ponderhit"))
+         pool.ponderhit();
+      else if (commandIs(line, "quit"))
+         pool.stop();
+
+      {
+         std::lock_guard<std::mutex> lock(commandMutex);
+         commands.push_back(line);
+      }
+      commandReady.notify_one();
+
+      if (commandIs(line, "quit"))
+         return;
+   }
+
+   // end of input means quit
+   pool.stop();
+   {
+      std::lock_guard<std::mutex> lock(commandMutex);
+      commands.push_back("quit");
+   }
+   commandReady.notify_one();
+}
+
+//------------------------------------------------------------------------------
+std::string GambitInterface::nextCommand () {
+   std::unique_lock<std::mutex> lock(commandMutex);
+   while (commands.empty())
+      commandReady.wait(lock);
+   std::string command = commands.front();
+   commands.pop_front();
+   return command;
+}
+
+//------------------------------------------------------------------------------
+bool GambitInterface::execute (std::string const& command) {
+   char const* p = command.c_str();
+   char const* token;
+   unsigned length;
+   if (!nextToken(p, token, length))
+      return true;
+
+   if (tokenIs(token, length, "uci")) {
+      uci();
+   } else if (tokenIs(token, length, "isready")) {
+      out.line("readyok");
+   } else if (tokenIs(token, length, "ucinewgame")) {
+      finishSearch();
+      pool.clear();
+      game.newGame();
+   } else if (tokenIs(token, length, "setoption")) {
+      finishSearch();
+      setOption(p);
+   } else if (tokenIs(token, length, "position")) {
+      finishSearch();
+      position(p);
+   } else if (tokenIs(token, length, "go")) {
+      finishSearch();
+      go(p);
+   } else if (tokenIs(token, length, "counters")) {
+      // not UCI: the hot path counts so far, as JSON (see Counters.h)
+      out.line("info string " + Counters::json(Counters::totals()));
+   } else if (tokenIs(token, length, "trace")) {
+      // not UCI: trace (start | stop | write <file>) (see Trace.h)
+      trace(p);
+   } else if (tokenIs(token, length, "stop")) {
+      // the input thread already stopped any running search, but not one
+      // whose go was still queued behind it
+      pool.stop();
+   } else if (tokenIs(token, length, "ponderhit")) {
+      pool.ponderhit();
+   } else if (tokenIs(token, length, "quit")) {
+      return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void GambitInterface::uci () {
+   out.line("id name AsciiChess");
+   out.line("id author Erik Strand");
+   out.line("option name Hash type spin default 16 min 1 max 65536");
+   out.line("option name Threads type spin default 1 min 1 max 256");
+   out.line("option name Ponder type check default false");
+   out.line("option name NullMove type check default true");
+   out.line("option name LateMoveReductions type check default true");
+   out.line("option name Futility type check default true");
+   out.line("option name ReverseFutility type check default true");
+   out.line("option name CheckExtensions type check default true");
+   out.line("option name OwnBook type check default false");
+   out.line("option name BookFile type string default <empty>");
+   out.line("option name TablebasePath type string default <empty>");
+   out.line("option name AnalysisCache type string default <empty>");
+   out.line("option name AnalysisCacheDepth type spin default 6 min 1 max 64");
+   out.line("uciok");
+}
+
+//------------------------------------------------------------------------------
+// setoption name <name> value <value>
+void GambitInterface::setOption (char const* args) {
+   char const* token;
+   unsigned length;
+   std::string name;
+   std::string value;
+   std::string* field = 0;
+   while (nextToken(args, token, length)) {
+      if (tokenIs(token, length, "name")) {
+         field = &name;
+      } else if (tokenIs(token, length, "value")) {
+         field = &value;
+      } else if (field) {
+         if (!field->empty())
+            *field += ' ';
+         field->append(token, length);
+      }
+   }
+
+   bool on = value == "true";
+   SearchOptions options = pool.mainSearcher().options();
+   if (name == "Hash") {
+      pool.setHashSize(atoi(value.c_str()));
+   } else if (name == "Threads") {
+      pool.setThreads(atoi(value.c_str()));
+   } else if (name == "NullMove") {
+      options.nullMove = on;
+   } else if (name == "LateMoveReductions") {
+      options.lateMoveReductions = on;
+   } else if (name == "Futility") {
+      options.futility = on;
+   } else if (name == "ReverseFutility") {
+      options.reverseFutility = on;
+   } else if (name == "CheckExtensions") {
+      options.checkExtensions = on;
+   } else if (name == "OwnBook") {
+      ownBook = on;
+   } else if (name == "BookFile") {
+      if (value.empty() || value == "<empty>")
+         book.close();
+      else if (!book.open(value.c_str()))
+         out.line("info string can't open book " + value);
+   } else if (name == "TablebasePath") {
+      pool.setTablebases(0);
+      tablebases.close();
+      if (!value.empty() && value != "<empty>") {
+         if (tablebases.load(value.c_str()) > 0)
+            pool.setTablebases(&tablebases);
+         else
+            out.line("info string no tablebases in " + value);
+      }
+   } else if (name == "AnalysisCache") {
+      pool.setAnalysisCache(0);
+      analysisCache.close();
+      if (!value.empty() && value != "<empty>") {
+         if (analysisCache.open(value.c_str()))
+            pool.setAnalysisCache(&analysisCache);
+         else
+            out.line("info string can't open analysis cache " + value);
+      }
+   } else if (name == "AnalysisCacheDepth") {
+      analysisCache.setMinDepth(atoi(value.c_str()));
+   }
+   pool.setOptions(options);
+}
+
+//------------------------------------------------------------------------------
+// position (startpos | fen <fen>) [moves <move> ...]
+void GambitInterface::position (char const* args) {
+   Trace::Scope scope("uci", "position");
+   char const* token;
+   unsigned length;
+   if (!nextToken(args, token, length))
+      return;
+
+   if (tokenIs(token, length, "startpos")) {
+      game.newGame();
+   } else if (tokenIs(token, length, "fen")) {
+      char const* fenEnd = strstr(args, " moves");
+      if (!fenEnd)
+         fenEnd = args + strlen(args);
+      Board b;
+      if (!Fen::read(args, fenEnd, b)) {
+         out.line("info string invalid fen " + std::string(args, fenEnd));
+         return;
+      }
+      game.setPosition(b);
+      args = fenEnd;
+   } else {
+      out.line("info string unsupported position command");
+      return;
+   }
+
+   if (!nextToken(args, token, length) || !tokenIs(token, length, "moves"))
+      return;
+   while (nextToken(args, token, length)) {
+      Move m = parseMove(game.currentBoard(), token, length);
+      if (!m.valid()) {
+         out.line("info string illegal move " + std::string(token, length));
+         return;
+      }
+      game.move(m);
+   }
+}
+
+//------------------------------------------------------------------------------
+// go [depth d] [nodes n] [movetime t] [wtime t] [btime t] [winc t] [binc t]
+//    [movestogo n] [infinite] [ponder]
+void GambitInterface::go (char const* args) {
+   limits = SearchLimits();
+   char const* token;
+   unsigned length;
+   char const* value;
+   unsigned valueLength;
+   while (nextToken(args, token, length)) {
+      if (tokenIs(token, length, "infinite")) {
+         limits.infinite = true;
+         continue;
+      }
+      if (tokenIs(token, length, "ponder")) {
+         limits.ponder = true;
+         continue;
+      }
+      if (!nextToken(args, value, valueLength))
+         break;
+      long long v = tokenValue(value, valueLength);
+      if (tokenIs(token, length, "depth"))          limits.depth = v;
+      else if (tokenIs(token, length, "nodes"))     limits.nodes = v;
+      else if (tokenIs(token, length, "movetime"))  limits.moveTime = v;
+      else if (tokenIs(token, length, "wtime"))     limits.lightTime = v;
+      else if (tokenIs(token, length, "btime"))     limits.darkTime = v;
+      else if (tokenIs(token, length, "winc"))      limits.lightIncrement = v;
+      else if (tokenIs(token, length, "binc"))      limits.darkIncrement = v;
+      else if (tokenIs(token, length, "movestogo")) limits.movesToGo = v;
+   }
+
+   // book moves are played at once (but never while pondering or analyzing)
+   if (ownBook && book.isOpen() && !limits.infinite && !limits.ponder && bookMove())
+      return;
+
+   // the search thread may run while the main thread handles new commands,
+   // so a stop or ponderhit that follows this go must find its signals set
+   pool.prepare(game.currentBoard(), limits);
+   Counters::reset();
+   searchThread = std::thread(&GambitInterface::runSearch, this);
+}
+
+//------------------------------------------------------------------------------
+bool GambitInterface::bookMove () {
+   Trace::Scope scope("uci", "book probe");
+   // xorshift64
+   bookRandom ^= bookRandom << 13;
+   bookRandom ^= bookRandom >> 7;
+   bookRandom ^= bookRandom << 17;
+   Move m = book.probe(game.currentBoard(), bookRandom);
+   if (!m.valid())
+      return false;
+   char buffer[8];
+   char* end = m.writeCoordinates(buffer);
+   out.line("info string book move");
+   out.line("bestmove " + std::string(buffer, end));
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void GambitInterface::finishSearch () {
+   if (searchThread.joinable()) {
+      pool.stop();
+      searchThread.join();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Runs on the search thread.
+void GambitInterface::runSearch () {
+   Trace::nameThread("search");
+   Board root = game.currentBoard();
+   Move best = pool.search(root, limits, true);
+
+   // infinite and ponder searches may not report before being told to
+   SearchSignals& signals = pool.signals();
+   while (!signals.stop && (limits.infinite || signals.pondering))
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+   char buffer[32];
+   char* end = best.valid() ? best.writeCoordinates(buffer) : buffer;
+   if (!best.valid()) {
+      memcpy(buffer, "0000", 4);
+      end = buffer + 4;
+   }
+   std::string line = "bestmove " + std::string(buffer, end);
+
+   Move pv[2];
+   if (best.valid() && pool.mainSearcher().principalVariation(root, pv, 2) == 2 && pv[0] == best) {
+      end = pv[1].writeCoordinates(buffer);
+      line += " ponder " + std::string(buffer, end);
+   }
+   if (Counters::enabled())
+      out.line(Counters::info(Counters::totals()));
+   Trace::instant("uci", "bestmove");
+   out.line(line);
+}
+
+//------------------------------------------------------------------------------
+// trace start | trace stop | trace write <file>
+void GambitInterface::trace (char const* args) {
+   char const* token;
+   unsigned length;
+   if (!nextToken(args, token, length)) {
+      out.line("info string usage: trace (start | stop | write <file>)");
+   } else if (tokenIs(token, length, "start")) {
+      Trace::start();
+   } else if (tokenIs(token, length, "stop")) {
+      Trace::stop();
+   } else if (tokenIs(token, length, "write")) {
+      char const* path;
+      unsigned pathLength;
+      if (!nextToken(args, path, pathLength))
+         out.line("info string usage: trace write <file>");
+      else if (!Trace::write(std::string(path, pathLength).c_str()))
+         out.line("info string can't write " + std::string(path, pathLength));
+   } else {
+      out.line("info string usage: trace (start | stop | write <file>)");
+   }
+}
+
+//------------------------------------------------------------------------------
+// Runs on the search thread.
+void GambitInterface::iterationDone (Searcher const& searcher, Board const& root,
+                                     unsigned depth, int score, long long elapsed) {
+   char buffer[256];
+   unsigned long long nodes = pool.nodes();
+   unsigned long long nps = elapsed > 0 ? nodes * 1000 / elapsed : nodes * 1000;
+
+   int n;
+   if (score > Score::mateBound)
+      n = snprintf(buffer, sizeof(buffer), "info depth %u score mate %d", depth, (Score::mate - score + 1) / 2);
+   else if (score < -Score::mateBound)
+      n = snprintf(buffer, sizeof(buffer), "info depth %u score mate %d", depth, -(Score::mate + score) / 2);
+   else
+      n = snprintf(buffer, sizeof(buffer), "info depth %u score cp %d", depth, score);
+   std::string line(buffer, n);
+
+   n = snprintf(buffer, sizeof(buffer), " nodes %llu nps %llu time %lld pv", nodes, nps, elapsed);
+   line.append(buffer, n);
+
+   Move pv[Searcher::maxPly];
+   unsigned length = searcher.principalVariation(root, pv, depth);
+   for (unsigned i=0; i<length; ++i) {
+      char* end = pv[i].writeCoordinates(buffer);
+      line += ' ';
+      line.append(buffer, end);
+   }
+   out.line(line);
+}
+
+//------------------------------------------------------------------------------
+Move GambitInterface::parseMove (Board const& b, char const* text, unsigned length) {
+   Move m;
+   if (San::resolve(b, text, text + length, m) != San::ok)
+      return Move();
+   return m;
+}
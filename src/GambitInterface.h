@@ -6,19 +6,118 @@
 #ifndef GAMBITINTERFACE
 #define GAMBITINTERFACE
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Book.h"
+#include "Tablebase.h"
+#include "AnalysisCache.h"
 #include "Chess.h"
+#include "Search.h"
 
 
+//==============================================================================
+// AsyncWriter
+//==============================================================================
+
 //------------------------------------------------------------------------------
-class GambitInterface {
+// Buffered output written to a file descriptor by its own thread.
+/*
+ * Writers only append to a buffer under a short lock, so a search thread never
+ * waits on a slow pipe or terminal.
+ */
+class AsyncWriter {
+private:
+   int fd;
+   std::string pending;
+   std::string writing;
+   std::mutex mutex;
+   std::condition_variable ready;
+   std::condition_variable drained;
+   bool busy;
+   bool quit;
+   std::thread thread;
+
+public:
+   AsyncWriter (int fd_);
+   ~AsyncWriter ();
+
+   void write (char const* text, unsigned length);
+   // writes a line (a newline is appended)
+   void line (std::string const& text);
+   // blocks until everything written so far has reached the descriptor
+   void flush ();
+
+private:
+   void run ();
+};
+
+
+//==============================================================================
+// GambitInterface
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Universal Chess Interface front end.
+/*
+ * A dedicated thread reads stdin. It acts on "stop", "ponderhit" and "quit"
+ * itself, so they reach a running search at once, and queues every command
+ * for the main thread, which applies stop and ponderhit again in order so
+ * they also reach a search whose go was still queued. Searches run on their
+ * own thread so the main thread can keep answering (ex, "isready") while one
+ * is in progress.
+ */
+class GambitInterface: public SearchObserver {
 private:
    Game game;
-   Generator generator;
+   SearchPool pool;
+   AsyncWriter out;
+
+   std::deque<std::string> commands;
+   std::mutex commandMutex;
+   std::condition_variable commandReady;
+   std::thread inputThread;
+
+   std::thread searchThread;
+   SearchLimits limits;
+
+   // consulted before searching when OwnBook is on
+   OpeningBook book;
+   bool ownBook;
+   HashKey bookRandom;
+   // scores the positions they cover once TablebasePath names a directory
+   Tablebases tablebases;
+   // results of earlier sessions, once AnalysisCache names a file
+   AnalysisCache analysisCache;
 
 public:
+   GambitInterface ();
+   ~GambitInterface ();
    void loop ();
+
+   void iterationDone (Searcher const& searcher, Board const& root,
+                       unsigned depth, int score, long long elapsed);
+
+private:
+   void readInput ();
+   std::string nextCommand ();
+   // returns false when it's time to quit
+   bool execute (std::string const& command);
+
+   void uci ();
+   void setOption (char const* args);
+   void position (char const* args);
+   void go (char const* args);
+   // answers go from the book; returns false if the position isn't in it
+   bool bookMove ();
+   void finishSearch ();
+   void runSearch ();
+   void trace (char const* args);
+
+   static Move parseMove (Board const& b, char const* text, unsigned length);
 };
 
 
 #endif
-
@@ -0,0 +1,410 @@
+//==============================================================================
+// GameArchive.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "GameArchive.h"
+#include <cstring>
+#include <thread>
+#include "PositionFile.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+char const magic[4] = { 'G', 'A', 'R', 'C' };
+unsigned const version = 1;
+unsigned const headerSize = 16;
+
+//------------------------------------------------------------------------------
+// Carry-less range coder (Subbotin). Totals must stay below bottom.
+static const unsigned top    = 1u << 24;
+static const unsigned bottom = 1u << 16;
+
+class RangeEncoder {
+private:
+   std::vector<unsigned char>& _out;
+   unsigned _low;
+   unsigned _range;
+
+public:
+   RangeEncoder (std::vector<unsigned char>& out): _out(out), _low(0), _range(~0u) {}
+
+   void encode (unsigned cumulative, unsigned frequency, unsigned total) {
+      _range /= total;
+      _low += cumulative * _range;
+      _range *= frequency;
+      while ((_low ^ (_low + _range)) < top
+             || (_range < bottom && ((_range = -_low & (bottom - 1)), true))) {
+         _out.push_back(_low >> 24);
+         _low <<= 8;
+         _range <<= 8;
+      }
+   }
+
+   void finish () {
+      for (unsigned i=0; i<4; ++i) {
+         _out.push_back(_low >> 24);
+         _low <<= 8;
+      }
+   }
+};
+
+//------------------------------------------------------------------------------
+class RangeDecoder {
+private:
+   unsigned char const* _p;
+   unsigned char const* _end;
+   unsigned _low;
+   unsigned _range;
+   unsigned _code;
+
+   // reading past the end yields zeros (the encoder's flush makes them unneeded)
+   unsigned next () { return _p < _end ? *_p++ : 0; }
+
+public:
+   RangeDecoder (unsigned char const* begin, unsigned char const* end):
+      _p(begin), _end(end), _low(0), _range(~0u), _code(0)
+   {
+      for (unsigned i=0; i<4; ++i)
+         _code = (_code << 8) | next();
+   }
+
+   // the cumulative frequency the next symbol falls on
+   unsigned target (unsigned total) {
+      _range /= total;
+      unsigned t = (_code - _low) / _range;
+      return t < total ? t : total - 1;
+   }
+
+   void consume (unsigned cumulative, unsigned frequency) {
+      _low += cumulative * _range;
+      _range *= frequency;
+      while ((_low ^ (_low + _range)) < top
+             || (_range < bottom && ((_range = -_low & (bottom - 1)), true))) {
+         _code = (_code << 8) | next();
+         _low <<= 8;
+         _range <<= 8;
+      }
+   }
+};
+
+//------------------------------------------------------------------------------
+// Adaptive frequencies of move indices; only [0, n) is in play for a move.
+class IndexModel {
+private:
+   static const unsigned increment = 24;
+   static const unsigned limit = 1 << 15;
+   unsigned short _frequency[MoveList::capacity];
+   unsigned _total;
+
+public:
+   IndexModel (): _total(MoveList::capacity) {
+      for (unsigned i=0; i<MoveList::capacity; ++i)
+         _frequency[i] = 1;
+   }
+
+   void encode (RangeEncoder& rc, unsigned index, unsigned n) {
+      unsigned cumulative = 0;
+      for (unsigned i=0; i<index; ++i)
+         cumulative += _frequency[i];
+      unsigned total = cumulative;
+      for (unsigned i=index; i<n; ++i)
+         total += _frequency[i];
+      rc.encode(cumulative, _frequency[index], total);
+      update(index);
+   }
+
+   // returns n if the code doesn't fit the model (only if it's corrupt)
+   unsigned decode (RangeDecoder& rc, unsigned n) {
+      unsigned total = 0;
+      for (unsigned i=0; i<n; ++i)
+         total += _frequency[i];
+      unsigned target = rc.target(total);
+      unsigned cumulative = 0;
+      unsigned index = 0;
+      while (index < n && cumulative + _frequency[index] <= target)
+         cumulative += _frequency[index++];
+      if (index == n)
+         return n;
+      rc.consume(cumulative, _frequency[index]);
+      update(index);
+      return index;
+   }
+
+private:
+   void update (unsigned index) {
+      _frequency[index] += increment;
+      _total += increment;
+      if (_total > limit) {
+         _total = 0;
+         for (unsigned i=0; i<MoveList::capacity; ++i) {
+            _frequency[i] = (_frequency[i] + 1) >> 1;
+            _total += _frequency[i];
+         }
+      }
+   }
+};
+
+//------------------------------------------------------------------------------
+void writeVarint (unsigned long long n, std::vector<unsigned char>& out) {
+   while (n >= 0x80) {
+      out.push_back((n & 0x7f) | 0x80);
+      n >>= 7;
+   }
+   out.push_back(n);
+}
+
+//------------------------------------------------------------------------------
+// Returns 0 if the varint runs past end.
+unsigned char const* readVarint (unsigned char const* p, unsigned char const* end,
+                                 unsigned long long& n) {
+   n = 0;
+   for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+      unsigned char byte = *p++;
+      n |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return p;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// The parts of the game at p. Returns 0 if it runs past end.
+unsigned char const* readGameHeader (unsigned char const* p, unsigned char const* end,
+                                     unsigned char& flags, PositionRecord const*& start,
+                                     unsigned long long& plies, unsigned long long& bytes) {
+   if (p >= end)
+      return 0;
+   flags = *p++;
+   start = 0;
+   if (flags & 0x1) {
+      if (end - p < static_cast<long>(sizeof(PositionRecord)))
+         return 0;
+      start = reinterpret_cast<PositionRecord const*>(p);
+      p += sizeof(PositionRecord);
+   }
+   if (!(p = readVarint(p, end, plies)) || !(p = readVarint(p, end, bytes)))
+      return 0;
+   if (static_cast<unsigned long long>(end - p) < bytes)
+      return 0;
+   return p;
+}
+
+//------------------------------------------------------------------------------
+void replayRange (GameArchive const* archive, unsigned long long begin,
+                  unsigned long long end, PgnObserver* observer, PgnStats* stats) {
+   *stats = archive->replay(begin, end, observer);
+}
+
+}
+
+
+//==============================================================================
+// Move Index Coding
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool MoveCode::encode (Game const& game, std::vector<unsigned char>& out) {
+   RangeEncoder rc(out);
+   IndexModel model;
+   MoveList list;
+   for (unsigned ply=0; ply<game.plies(); ++ply) {
+      generatePseudoLegalMoves(game.board(ply), list);
+      unsigned index = 0;
+      while (index < list.size && list[index] != game.moveAt(ply))
+         ++index;
+      if (index == list.size)
+         return false;
+      model.encode(rc, index, list.size);
+   }
+   rc.finish();
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool MoveCode::decode (unsigned char const* begin, unsigned char const* end, unsigned plies,
+                       Game& game, PgnObserver* observer) {
+   RangeDecoder rc(begin, end);
+   IndexModel model;
+   MoveList list;
+   for (unsigned ply=0; ply<plies; ++ply) {
+      generatePseudoLegalMoves(game.currentBoard(), list);
+      unsigned index = model.decode(rc, list.size);
+      if (index == list.size)
+         return false;
+      game.move(list[index]);
+      if (observer)
+         observer->movePlayed(game, list[index]);
+   }
+   return true;
+}
+
+
+//==============================================================================
+// Game Archive Writer
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool GameArchiveWriter::open (char const* path) {
+   close();
+   _file = std::fopen(path, "wb");
+   if (!_file)
+      return false;
+   std::setvbuf(_file, 0, _IOFBF, 1 << 20);
+   unsigned header[4] = { 0, version, 0, 0 };
+   memcpy(header, magic, 4);
+   _games = 0;
+   _bytes = headerSize;
+   return std::fwrite(header, headerSize, 1, _file) == 1;
+}
+
+//------------------------------------------------------------------------------
+bool GameArchiveWriter::add (Game const& game) {
+   Board standard;
+   standard.setupNewGame();
+   Board const& start = game.board(0);
+   bool custom = memcmp(start.bitboard().words(), standard.bitboard().words(), 32) != 0
+              || start.pathDependence().packedFlags() != standard.pathDependence().packedFlags()
+              || start.pathDependence().halfmoveClock() != 0
+              || start.pathDependence().fullmoveNumber() != 1;
+
+   _buffer.clear();
+   _buffer.push_back(custom ? 0x1 : 0x0);
+   if (custom) {
+      PositionRecord record;
+      record.pack(start);
+      unsigned char const* p = reinterpret_cast<unsigned char const*>(&record);
+      _buffer.insert(_buffer.end(), p, p + sizeof(record));
+   }
+   // the code goes after its length, so it's built separately
+   std::vector<unsigned char> code;
+   if (!MoveCode::encode(game, code))
+      return false;
+   writeVarint(game.plies(), _buffer);
+   writeVarint(code.size(), _buffer);
+   _buffer.insert(_buffer.end(), code.begin(), code.end());
+
+   if (std::fwrite(&_buffer[0], _buffer.size(), 1, _file) != 1)
+      return false;
+   ++_games;
+   _bytes += _buffer.size();
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool GameArchiveWriter::close () {
+   if (!_file)
+      return true;
+   bool ok = std::fclose(_file) == 0;
+   _file = 0;
+   return ok;
+}
+
+
+//==============================================================================
+// Game Archive
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool GameArchive::open (char const* path) {
+   close();
+   if (!_file.open(path))
+      return false;
+   unsigned header[4] = { 0, 0, 0, 0 };
+   if (_file.size() >= headerSize)
+      memcpy(header, _file.begin(), headerSize);
+   if (memcmp(header, magic, 4) != 0 || header[1] != version) {
+      _file.close();
+      return false;
+   }
+
+   unsigned char const* begin = reinterpret_cast<unsigned char const*>(_file.begin());
+   unsigned char const* end = reinterpret_cast<unsigned char const*>(_file.end());
+   unsigned char const* p = begin + headerSize;
+   while (p < end) {
+      unsigned char flags;
+      PositionRecord const* start;
+      unsigned long long plies, bytes;
+      unsigned char const* code = readGameHeader(p, end, flags, start, plies, bytes);
+      // a truncated last game is dropped
+      if (!code)
+         break;
+      _offsets.push_back(p - begin);
+      p = code + bytes;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool GameArchive::decode (unsigned long long i, Game& game, PgnObserver* observer) const {
+   unsigned char const* begin = reinterpret_cast<unsigned char const*>(_file.begin());
+   unsigned char const* end = reinterpret_cast<unsigned char const*>(_file.end());
+   unsigned char flags;
+   PositionRecord const* start;
+   unsigned long long plies, bytes;
+   unsigned char const* code = readGameHeader(begin + _offsets[i], end, flags, start, plies, bytes);
+
+   if (start) {
+      // the record may not be aligned in the file
+      PositionRecord record;
+      memcpy(&record, start, sizeof(record));
+      Board b;
+      record.unpack(b);
+      game.setPosition(b);
+   } else {
+      game.newGame();
+   }
+   if (observer)
+      observer->gameStarted(game.currentBoard());
+   bool ok = MoveCode::decode(code, code + bytes, plies, game, observer);
+   if (observer)
+      observer->gameFinished(game, ok);
+   return ok;
+}
+
+//------------------------------------------------------------------------------
+PgnStats GameArchive::replay (unsigned long long begin, unsigned long long end,
+                              PgnObserver* observer) const {
+   PgnStats stats;
+   Game game;
+   for (unsigned long long i=begin; i<end; ++i) {
+      if (decode(i, game, observer))
+         stats.addEnding(game.currentBoard());
+      else
+         ++stats.errors;
+      ++stats.games;
+      stats.moves += game.plies();
+   }
+   if (begin < end) {
+      unsigned long long last = end < size() ? _offsets[end] : _file.size();
+      stats.bytes = last - _offsets[begin];
+   }
+   return stats;
+}
+
+//------------------------------------------------------------------------------
+PgnStats GameArchive::replay (unsigned threads, PgnObserver* const* observers) const {
+   if (threads == 0)
+      threads = 1;
+   unsigned long long games = size();
+   std::vector<PgnStats> stats(threads);
+   std::vector<std::thread> workers;
+   for (unsigned i=1; i<threads; ++i) {
+      workers.push_back(std::thread(replayRange, this, games * i / threads,
+                                    games * (i + 1) / threads,
+                                    observers ? observers[i] : 0, &stats[i]));
+   }
+   stats[0] = replay(0, games / threads, observers ? observers[0] : 0);
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+
+   PgnStats total;
+   for (unsigned i=0; i<threads; ++i)
+      total.add(stats[i]);
+   return total;
+}
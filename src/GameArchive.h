@@ -0,0 +1,101 @@
+//==============================================================================
+// GameArchive.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef GAMEARCHIVE
+#define GAMEARCHIVE
+
+#include <cstdio>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+
+
+//==============================================================================
+// Move Index Coding
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Games stored as the index of each move in the generator's enumeration order.
+/*
+ * Moves are numbered as generatePseudoLegalMoves lists them (source square,
+ * then generator state, then special moves), so a move costs about log2 of
+ * the number of pseudo legal moves: 5 or 6 bits. Indices are range coded with
+ * a model restricted to [0, n) that adapts to the indices seen so far in the
+ * game. Each game is coded on its own, so games decode independently.
+ *
+ * Decoding never tests legality: it lists the moves, picks the indexed one
+ * and realizes it, which makes rebuilding positions cheap. The archive is
+ * trusted to hold legal games.
+ */
+namespace MoveCode {
+   // appends the coded moves of game to out; fails if a move isn't one the
+   // generator lists
+   bool encode (Game const& game, std::vector<unsigned char>& out);
+   // decodes plies moves from [begin, end) onto game (which holds the start
+   // position); returns false if the code is corrupt
+   bool decode (unsigned char const* begin, unsigned char const* end, unsigned plies,
+                Game& game, PgnObserver* observer = 0);
+}
+
+
+//==============================================================================
+// Game Archive
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Appends games to an archive file.
+/*
+ * After a 16 byte header each game is: a flags byte (0x1: a start position
+ * follows as a PositionRecord, otherwise it's the standard one), the number of
+ * plies and the number of code bytes (both as LEB128 varints), then the code.
+ */
+class GameArchiveWriter {
+private:
+   std::FILE* _file;
+   unsigned long long _games;
+   unsigned long long _bytes;
+   std::vector<unsigned char> _buffer;
+
+   GameArchiveWriter (GameArchiveWriter const&);
+   void operator= (GameArchiveWriter const&);
+
+public:
+   GameArchiveWriter (): _file(0), _games(0), _bytes(0) {}
+   ~GameArchiveWriter () { close(); }
+
+   bool open (char const* path);
+   // returns false if the game can't be coded or the file can't be written
+   bool add (Game const& game);
+   bool close ();
+   unsigned long long games () const { return _games; }
+   // bytes written so far, header included
+   unsigned long long bytes () const { return _bytes; }
+};
+
+//------------------------------------------------------------------------------
+// A mapped archive. Opening it indexes where each game starts.
+class GameArchive {
+private:
+   MappedFile _file;
+   std::vector<unsigned long long> _offsets;
+
+public:
+   bool open (char const* path);
+   void close () { _file.close(); _offsets.clear(); }
+   unsigned long long size () const { return _offsets.size(); }
+
+   // replaces game with game i; returns false if it's corrupt
+   bool decode (unsigned long long i, Game& game, PgnObserver* observer = 0) const;
+   // decodes games [begin, end) on the calling thread
+   PgnStats replay (unsigned long long begin, unsigned long long end,
+                    PgnObserver* observer = 0) const;
+   // decodes every game, split into contiguous ranges over the given number of
+   // threads; observers, if given, holds one observer per thread
+   PgnStats replay (unsigned threads, PgnObserver* const* observers = 0) const;
+};
+
+
+#endif
@@ -0,0 +1,42 @@
+//==============================================================================
+// MappedFile.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+//------------------------------------------------------------------------------
+bool MappedFile::open (char const* path) {
+   close();
+   int fd = ::open(path, O_RDONLY);
+   if (fd < 0)
+      return false;
+   struct stat info;
+   if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+      ::close(fd);
+      return false;
+   }
+   void* p = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   // the mapping outlives the descriptor
+   ::close(fd);
+   if (p == MAP_FAILED)
+      return false;
+   // we read front to back
+   madvise(p, info.st_size, MADV_SEQUENTIAL);
+   _data = static_cast<char const*>(p);
+   _size = info.st_size;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void MappedFile::close () {
+   if (_data)
+      munmap(const_cast<char*>(_data), _size);
+   _data = 0;
+   _size = 0;
+}
@@ -0,0 +1,42 @@
+//==============================================================================
+// MappedFile.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef MAPPEDFILE
+#define MAPPEDFILE
+
+
+//==============================================================================
+// Mapped File
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// A whole file mapped read only into memory.
+/*
+ * Only regular files can be mapped; open fails on pipes and terminals, so
+ * callers that must also read those should fall back to reading in chunks.
+ */
+class MappedFile {
+private:
+   char const* _data;
+   unsigned long long _size;
+
+   MappedFile (MappedFile const&);
+   void operator= (MappedFile const&);
+
+public:
+   MappedFile (): _data(0), _size(0) {}
+   ~MappedFile () { close(); }
+
+   bool open (char const* path);
+   void close ();
+
+   bool isOpen () const { return _data != 0; }
+   char const* begin () const { return _data; }
+   char const* end   () const { return _data + _size; }
+   unsigned long long size () const { return _size; }
+};
+
+
+#endif
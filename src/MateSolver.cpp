@@ -0,0 +1,209 @@
+//==============================================================================
+// MateSolver.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "MateSolver.h"
+#include <algorithm>
+#include "Search.h"
+
+
+//==============================================================================
+// Mate Solver
+//==============================================================================
+
+//------------------------------------------------------------------------------
+MateSolver::MateSolver (unsigned megabytes): _mask(0), _nodes(0), _nodeLimit(0) {
+   resize(megabytes);
+}
+
+//------------------------------------------------------------------------------
+// Rounded down to a power of two entries, as in TranspositionTable.
+void MateSolver::resize (unsigned megabytes) {
+   unsigned long long bytes = static_cast<unsigned long long>(megabytes) << 20;
+   unsigned long long count = 2;
+   while ((count << 1) * sizeof(Entry) <= bytes)
+      count <<= 1;
+   _table.resize(count);
+   _mask = count - 1;
+   clear();
+}
+
+//------------------------------------------------------------------------------
+void MateSolver::clear () {
+   Entry empty = { 0, 1, 1 };
+   std::fill(_table.begin(), _table.end(), empty);
+}
+
+//------------------------------------------------------------------------------
+HashKey MateSolver::keyOf (Board const& b, unsigned remaining) const {
+   return positionKey(b) ^ (remaining * 0x9e3779b97f4a7c15ull);
+}
+
+//------------------------------------------------------------------------------
+// Entries come in pairs: a solved node can only be displaced by another solved
+// node, so proofs survive the churn of nodes still being worked on.
+void MateSolver::lookup (HashKey key, unsigned& phi, unsigned& delta) const {
+   unsigned long long i = key & _mask;
+   Entry const* e = _table[i].key == key ? &_table[i]
+                  : _table[i ^ 1].key == key ? &_table[i ^ 1] : 0;
+   phi = e ? e->phi : 1;
+   delta = e ? e->delta : 1;
+}
+
+//------------------------------------------------------------------------------
+void MateSolver::store (HashKey key, unsigned phi, unsigned delta) {
+   unsigned long long i = key & _mask;
+   if (_table[i ^ 1].key == key)
+      i ^= 1;
+   else if (_table[i].key != key && (_table[i].phi == 0 || _table[i].delta == 0)
+            && phi != 0 && delta != 0)
+      i ^= 1;
+   Entry e = { key, phi, delta };
+   _table[i] = e;
+}
+
+//------------------------------------------------------------------------------
+// Legal moves, checks first. The attacker's last move must give check.
+void MateSolver::generate (Board const& b, bool attacker, unsigned remaining, MoveList& list) {
+   MoveList moves;
+   if (attacker && remaining == 1) {
+      generateChecks(b, moves);
+   } else if (attacker) {
+      MoveList quiet;
+      generateChecks(b, moves);
+      generatePseudoLegalMoves(b, quiet);
+      for (unsigned i=0; i<quiet.size; ++i) {
+         if (!givesCheck(b, quiet[i]))
+            moves.push(quiet[i]);
+      }
+   } else {
+      generatePseudoLegalMoves(b, moves);
+   }
+
+   list.clear();
+   bool light = b.pathDependence().lightMove();
+   Board child;
+   for (unsigned i=0; i<moves.size; ++i) {
+      b.realize(moves[i], child);
+      if (!_arbiter.isInCheck(child.bitboard(), light))
+         list.push(moves[i]);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Expands b until its proof or disproof number reaches its threshold. phi and
+// delta are the proof and disproof numbers for the side to move, so the same
+// code serves both sides: a node's phi is its children's least delta, and its
+// delta the sum of their phis.
+void MateSolver::mid (Board const& b, bool attacker, unsigned remaining,
+                      unsigned thPhi, unsigned thDelta) {
+   HashKey key = keyOf(b, remaining);
+   unsigned phi, delta;
+   lookup(key, phi, delta);
+   if (phi >= thPhi || delta >= thDelta)
+      return;
+   ++_nodes;
+
+   // out of moves, the defender has won unless it is mated
+   if (!attacker && remaining == 0) {
+      if (isCheckmate(b))
+         store(key, infinity, 0);
+      else
+         store(key, 0, infinity);
+      return;
+   }
+
+   MoveList list;
+   generate(b, attacker, remaining, list);
+   if (list.size == 0) {
+      // the attacker has failed; the defender is mated, or stalemated
+      if (attacker || _arbiter.isInCheck(b.bitboard(), b.pathDependence().lightMove()))
+         store(key, infinity, 0);
+      else
+         store(key, 0, infinity);
+      return;
+   }
+
+   unsigned childRemaining = attacker ? remaining - 1 : remaining;
+   std::vector<Board> children(list.size);
+   std::vector<HashKey> keys(list.size);
+   for (unsigned i=0; i<list.size; ++i) {
+      b.realize(list[i], children[i]);
+      keys[i] = keyOf(children[i], childRemaining);
+   }
+
+   for (;;) {
+      unsigned long long sum = 0;
+      unsigned least = infinity;
+      unsigned second = infinity;
+      unsigned best = 0;
+      unsigned bestPhi = 0;
+      for (unsigned i=0; i<list.size; ++i) {
+         unsigned childPhi, childDelta;
+         lookup(keys[i], childPhi, childDelta);
+         sum += childPhi;
+         if (childDelta < least) {
+            second = least;
+            least = childDelta;
+            best = i;
+            bestPhi = childPhi;
+         } else if (childDelta < second) {
+            second = childDelta;
+         }
+      }
+      phi = least;
+      delta = sum >= infinity ? infinity : static_cast<unsigned>(sum);
+      if (phi >= thPhi || delta >= thDelta || (_nodeLimit && _nodes >= _nodeLimit)) {
+         store(key, phi, delta);
+         return;
+      }
+
+      unsigned long long childThPhi = static_cast<unsigned long long>(thDelta) - delta + bestPhi;
+      unsigned childThDelta = second < thPhi - 1 ? second + 1 : thPhi;
+      mid(children[best], !attacker, childRemaining,
+          childThPhi >= infinity ? infinity : static_cast<unsigned>(childThPhi), childThDelta);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Tries each length in turn, so the first proof is the shortest mate.
+MateSolver::Result MateSolver::solve (Board const& b, unsigned maxMoves) {
+   Result r;
+   r.moves = 0;
+   r.nodes = 0;
+   r.complete = true;
+   _nodes = 0;
+
+   for (unsigned n=1; n<=maxMoves; ++n) {
+      mid(b, true, n, infinity, infinity);
+      unsigned phi, delta;
+      lookup(keyOf(b, n), phi, delta);
+      if (phi != 0 && delta != 0) {
+         r.complete = false;
+         break;
+      }
+      if (phi != 0)
+         continue;
+
+      // the move whose defender node was proven lost; re-prove it if the
+      // entry has been displaced
+      r.moves = n;
+      MoveList list;
+      generate(b, true, n, list);
+      Board child;
+      for (unsigned pass=0; pass<2 && !r.move.valid(); ++pass) {
+         for (unsigned i=0; i<list.size && !r.move.valid(); ++i) {
+            b.realize(list[i], child);
+            if (pass == 1)
+               mid(child, false, n - 1, infinity, infinity);
+            lookup(keyOf(child, n - 1), phi, delta);
+            if (delta == 0)
+               r.move = list[i];
+         }
+      }
+      break;
+   }
+   r.nodes = _nodes;
+   return r;
+}
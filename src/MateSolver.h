@@ -0,0 +1,79 @@
+//==============================================================================
+// MateSolver.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef MATESOLVER
+#define MATESOLVER
+
+#include <vector>
+#include "Chess.h"
+
+
+//==============================================================================
+// Mate Solver
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Proves or refutes "mate in n" with depth first proof number search (df-pn).
+/*
+ * The side to move is the attacker. At its nodes one move must lead to mate
+ * (proof numbers take the minimum over the moves, disproof numbers the sum);
+ * at the defender's nodes every move must. Each node is keyed by its position
+ * and the attacker moves left, so no path can reach the same node twice and
+ * the search never has to deal with cycles. Proof and disproof numbers live
+ * in a transposition table (always replace, which can only cost re-search),
+ * and df-pn's thresholds let it go deep into the most promising line without
+ * keeping the tree in memory.
+ *
+ * The attacker's last move has to give check, so only checks are generated
+ * there (see generateChecks); elsewhere checks are tried first.
+ *
+ * A solver is used by one thread at a time.
+ */
+class MateSolver {
+public:
+   struct Result {
+      unsigned moves;                // the shortest mate found, 0 if none
+      Move move;                     // the first move of that mate
+      unsigned long long nodes;
+      bool complete;                 // false if the node limit cut the search short
+   };
+
+private:
+   struct Entry {
+      HashKey key;
+      unsigned phi;     // the proof number for the side to move
+      unsigned delta;   // its disproof number
+   };
+   std::vector<Entry> _table;
+   unsigned long long _mask;
+   unsigned long long _nodes;
+   unsigned long long _nodeLimit;
+   PathIndependentArbiter _arbiter;
+
+   MateSolver (MateSolver const&);
+   void operator= (MateSolver const&);
+
+public:
+   static const unsigned infinity = 0x7fffffff;
+
+   MateSolver (unsigned megabytes = 16);
+   void resize (unsigned megabytes);
+   void clear ();
+   // nodes per solve(), 0 for no limit
+   void setNodeLimit (unsigned long long nodes) { _nodeLimit = nodes; }
+
+   // finds the shortest mate by the side to move in at most maxMoves moves
+   Result solve (Board const& b, unsigned maxMoves);
+
+private:
+   HashKey keyOf (Board const& b, unsigned remaining) const;
+   void lookup (HashKey key, unsigned& phi, unsigned& delta) const;
+   void store (HashKey key, unsigned phi, unsigned delta);
+   void generate (Board const& b, bool attacker, unsigned remaining, MoveList& list);
+   void mid (Board const& b, bool attacker, unsigned remaining, unsigned thPhi, unsigned thDelta);
+};
+
+
+#endif
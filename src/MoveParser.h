@@ -4,6 +4,7 @@
 //==============================================================================
 
 #include "Chess.h"
+#include "San.h"
 #include <string>
 
 
@@ -11,29 +12,19 @@
 // Move Parser
 //==============================================================================
 
+//------------------------------------------------------------------------------
+// Reads moves typed by a player, in SAN, LAN or coordinates (see San).
 struct MoveParser {
-   Generator _gen;
+   Board const* _board;
    std::string command;
    std::string error;
-   char piece;
-   char file1;
-   char rank1;
-   bool capture;
-   char file2;
-   char rank2;
-   bool foundPiece;
-   bool foundFile1;
-   bool foundRank1;
-   bool foundFile2;
-   bool foundRank2;
+   Move move;
 
-   Generator const& getMove (Board const& b);
+   // reads a move from standard input; move is invalid (and error says why)
+   // if it can't be played
+   Move const& getMove (Board const& b);
 
-   void setBoard (Board const& b) { _gen.setBoard(b); }
-   // Returns 0 if it doesn't understand the command,
-   // 1 if the command makes sense but must be verified,
-   // and 2 if the command makes sense and need not be verified.
-   int parse (char const* command);
-   bool verify ();
+   void setBoard (Board const& b) { _board = &b; }
+   // resolves command against the board, setting move on success
+   San::Status parse (char const* command);
 };
-
@@ -0,0 +1,325 @@
+//==============================================================================
+// OpeningTree.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "OpeningTree.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include "Search.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+char const magic[4] = { 'G', 'T', 'R', 'E' };
+unsigned const version = 1;
+unsigned const headerSize = 16;
+
+// collectors hand records over this many at a time
+unsigned const batchSize = 4096;
+
+//------------------------------------------------------------------------------
+inline unsigned shardOf (HashKey key) {
+   return key >> (64 - OpeningTreeBuilder::shardBits);
+}
+
+//------------------------------------------------------------------------------
+// The shard is picked by the top bits, so the slot is picked by the bottom ones.
+inline unsigned slotOf (TreeRecord const& r, unsigned mask) {
+   return (r.key ^ (r.move * 0x9e3779b97f4a7c15ull)) & mask;
+}
+
+//------------------------------------------------------------------------------
+bool writeRecords (std::FILE* file, TreeRecord const* records, unsigned long long count) {
+   return count == 0 || std::fwrite(records, sizeof(TreeRecord), count, file) == count;
+}
+
+//------------------------------------------------------------------------------
+// One sorted source of a shard merge: a run file or the sorted table.
+struct Source {
+   TreeRecord const* p;
+   TreeRecord const* end;
+};
+
+struct LaterSource {
+   bool operator() (Source const& a, Source const& b) const { return *b.p < *a.p; }
+};
+
+}
+
+
+//==============================================================================
+// Tree Records
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void TreeRecord::add (TreeRecord const& r) {
+   games += r.games;
+   lightWins += r.lightWins;
+   draws += r.draws;
+   darkWins += r.darkWins;
+   if (r.firstPly < firstPly)
+      firstPly = r.firstPly;
+}
+
+
+//==============================================================================
+// Tree Builder
+//==============================================================================
+
+//------------------------------------------------------------------------------
+OpeningTreeBuilder::OpeningTreeBuilder (char const* path, unsigned long long memory):
+   _capacity(1024),
+   _path(path),
+   _failed(false)
+{
+   unsigned long long perShard = memory / (sizeof(TreeRecord) << shardBits);
+   while (_capacity * 2ull <= perShard && _capacity < (1u << 30))
+      _capacity *= 2;
+}
+
+//------------------------------------------------------------------------------
+OpeningTreeBuilder::~OpeningTreeBuilder () {
+   removeRuns();
+}
+
+//------------------------------------------------------------------------------
+unsigned OpeningTreeBuilder::runs () const {
+   unsigned n = 0;
+   for (unsigned s=0; s<(1u << shardBits); ++s)
+      n += _shards[s].runs.size();
+   return n;
+}
+
+//------------------------------------------------------------------------------
+void OpeningTreeBuilder::removeRuns () {
+   for (unsigned s=0; s<(1u << shardBits); ++s) {
+      for (unsigned i=0; i<_shards[s].runs.size(); ++i)
+         std::remove(_shards[s].runs[i].c_str());
+      _shards[s].runs.clear();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Sorting the batch groups it by shard, so each shard is locked once.
+void OpeningTreeBuilder::add (TreeRecord* records, unsigned count) {
+   std::sort(records, records + count);
+   unsigned i = 0;
+   while (i < count) {
+      unsigned index = shardOf(records[i].key);
+      Shard& shard = _shards[index];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (shard.table.empty())
+         shard.table.assign(_capacity, TreeRecord());
+      for ( ; i < count && shardOf(records[i].key) == index; ++i)
+         insert(shard, index, records[i]);
+   }
+}
+
+//------------------------------------------------------------------------------
+void OpeningTreeBuilder::insert (Shard& shard, unsigned index, TreeRecord const& r) {
+   unsigned mask = _capacity - 1;
+   unsigned slot = slotOf(r, mask);
+   while (shard.table[slot].games && !shard.table[slot].sameMove(r))
+      slot = (slot + 1) & mask;
+   if (shard.table[slot].games) {
+      shard.table[slot].add(r);
+      return;
+   }
+   shard.table[slot] = r;
+   // spill at three quarters full to keep probes short
+   if (++shard.count >= _capacity / 4 * 3 && !spill(shard, index))
+      _failed = true;
+}
+
+//------------------------------------------------------------------------------
+bool OpeningTreeBuilder::spill (Shard& shard, unsigned index) {
+   std::vector<TreeRecord> sorted;
+   sorted.reserve(shard.count);
+   for (unsigned i=0; i<_capacity; ++i) {
+      if (shard.table[i].games)
+         sorted.push_back(shard.table[i]);
+   }
+   std::sort(sorted.begin(), sorted.end());
+   memset(&shard.table[0], 0, _capacity * sizeof(TreeRecord));
+   shard.count = 0;
+
+   char suffix[32];
+   std::sprintf(suffix, ".run%u.%u", index, static_cast<unsigned>(shard.runs.size()));
+   std::string path = _path + suffix;
+   std::FILE* file = std::fopen(path.c_str(), "wb");
+   if (!file)
+      return false;
+   shard.runs.push_back(path);
+   std::setvbuf(file, 0, _IOFBF, 1 << 20);
+   bool ok = writeRecords(file, &sorted[0], sorted.size());
+   return std::fclose(file) == 0 && ok;
+}
+
+//------------------------------------------------------------------------------
+long long OpeningTreeBuilder::write () {
+   std::FILE* file = _failed ? 0 : std::fopen(_path.c_str(), "wb");
+   if (!file) {
+      removeRuns();
+      return -1;
+   }
+   std::setvbuf(file, 0, _IOFBF, 1 << 20);
+   unsigned header[4] = { 0, version, 0, 0 };
+   memcpy(header, magic, 4);
+   bool ok = std::fwrite(header, headerSize, 1, file) == 1;
+
+   unsigned long long written = 0;
+   for (unsigned s=0; s<(1u << shardBits) && ok; ++s) {
+      Shard& shard = _shards[s];
+      std::vector<TreeRecord> sorted;
+      sorted.reserve(shard.count);
+      for (unsigned i=0; i<shard.table.size(); ++i) {
+         if (shard.table[i].games)
+            sorted.push_back(shard.table[i]);
+      }
+      std::vector<TreeRecord>().swap(shard.table);
+      std::sort(sorted.begin(), sorted.end());
+
+      // k-way merge of the runs and the table, summing repeated moves
+      std::vector<MappedFile> runs(shard.runs.size());
+      std::priority_queue<Source, std::vector<Source>, LaterSource> sources;
+      for (unsigned i=0; i<runs.size(); ++i) {
+         if (!runs[i].open(shard.runs[i].c_str())) {
+            ok = false;
+            continue;
+         }
+         Source source = { reinterpret_cast<TreeRecord const*>(runs[i].begin()),
+                           reinterpret_cast<TreeRecord const*>(runs[i].end()) };
+         sources.push(source);
+      }
+      if (!sorted.empty()) {
+         Source source = { &sorted[0], &sorted[0] + sorted.size() };
+         sources.push(source);
+      }
+
+      std::vector<TreeRecord> out;
+      out.reserve(batchSize);
+      while (!sources.empty() && ok) {
+         Source source = sources.top();
+         sources.pop();
+         if (!out.empty() && out.back().sameMove(*source.p))
+            out.back().add(*source.p);
+         else {
+            if (out.size() == batchSize) {
+               ok = writeRecords(file, &out[0], out.size() - 1);
+               written += out.size() - 1;
+               out[0] = out.back();
+               out.resize(1);
+            }
+            out.push_back(*source.p);
+         }
+         if (++source.p < source.end)
+            sources.push(source);
+      }
+      ok = ok && writeRecords(file, out.empty() ? 0 : &out[0], out.size());
+      written += out.size();
+
+      for (unsigned i=0; i<runs.size(); ++i) {
+         runs[i].close();
+         std::remove(shard.runs[i].c_str());
+      }
+      shard.runs.clear();
+   }
+
+   header[2] = static_cast<unsigned>(written);
+   header[3] = static_cast<unsigned>(written >> 32);
+   ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, headerSize, 1, file) == 1;
+   ok = std::fclose(file) == 0 && ok;
+   removeRuns();
+   return ok ? static_cast<long long>(written) : -1;
+}
+
+//------------------------------------------------------------------------------
+void TreeCollector::tag (char const* name, unsigned nameLength,
+                         char const* value, unsigned valueLength) {
+   if (nameLength == 6 && strncmp(name, "Result", 6) == 0) {
+      std::string r(value, valueLength);
+      _result = r == "1-0" ? 1 : r == "0-1" ? -1 : r == "1/2-1/2" ? 0 : 2;
+   }
+}
+
+//------------------------------------------------------------------------------
+void TreeCollector::gameFinished (Game const& game, bool ok) {
+   for (unsigned ply=0; ok && ply<game.plies() && ply<_plies; ++ply) {
+      TreeRecord r;
+      r.key = positionKey(game.board(ply));
+      r.games = 1;
+      r.lightWins = _result == 1;
+      r.draws = _result == 0;
+      r.darkWins = _result == -1;
+      r.move = game.moveAt(ply).pack();
+      r.firstPly = ply;
+      r.reserved = 0;
+      _batch.push_back(r);
+   }
+   _result = 2;
+   if (_batch.size() >= batchSize)
+      flush();
+}
+
+//------------------------------------------------------------------------------
+void TreeCollector::flush () {
+   if (!_batch.empty())
+      _builder.add(&_batch[0], _batch.size());
+   _batch.clear();
+}
+
+
+//==============================================================================
+// Opening Tree
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool OpeningTree::open (char const* path) {
+   close();
+   if (!_file.open(path))
+      return false;
+   unsigned header[4] = { 0, 0, 0, 0 };
+   if (_file.size() >= headerSize)
+      memcpy(header, _file.begin(), headerSize);
+   unsigned long long size = header[2] | (static_cast<unsigned long long>(header[3]) << 32);
+   if (memcmp(header, magic, 4) != 0 || header[1] != version
+       || _file.size() != headerSize + size * sizeof(TreeRecord)) {
+      _file.close();
+      return false;
+   }
+   _records = reinterpret_cast<TreeRecord const*>(_file.begin() + headerSize);
+   _size = size;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+unsigned OpeningTree::find (HashKey key, TreeRecord const*& first) const {
+   // lower bound
+   unsigned long long low = 0;
+   unsigned long long high = _size;
+   while (low < high) {
+      unsigned long long middle = low + (high - low) / 2;
+      if (_records[middle].key < key)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   first = _records + low;
+   unsigned n = 0;
+   while (low + n < _size && _records[low + n].key == key)
+      ++n;
+   return n;
+}
+
+//------------------------------------------------------------------------------
+unsigned OpeningTree::find (Board const& b, TreeRecord const*& first) const {
+   return find(positionKey(b), first);
+}
@@ -0,0 +1,146 @@
+//==============================================================================
+// OpeningTree.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef OPENINGTREE
+#define OPENINGTREE
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Chess.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+
+
+//==============================================================================
+// Tree Records
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// How often one move was played from one position, and how those games ended.
+/*
+ * Positions are keyed by positionKey (see Search.h), so transpositions share
+ * their records. games counts every game, including those with no result.
+ */
+struct TreeRecord {
+   HashKey key;
+   unsigned games;
+   unsigned lightWins;
+   unsigned draws;
+   unsigned darkWins;
+   unsigned short move;       // Move::pack
+   unsigned short firstPly;   // the earliest ply the position was seen at
+   unsigned reserved;         // 0, pads the record to 32 bytes
+
+   bool operator< (TreeRecord const& r) const {
+      return key != r.key ? key < r.key : move < r.move;
+   }
+   bool sameMove (TreeRecord const& r) const { return key == r.key && move == r.move; }
+   void add (TreeRecord const& r);
+};
+
+
+//==============================================================================
+// Tree Builder
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Aggregates records from many threads and writes them as a sorted index.
+/*
+ * Records go to one of 256 shards by the top bits of their key, each an open
+ * addressing table behind its own lock, so threads rarely wait on each other.
+ * The shards split the memory budget. A full shard is sorted and spilled to a
+ * run file beside the index, so corpora with more positions than memory only
+ * cost disk space. write() merges each shard's runs with what's still in
+ * memory; since shards partition the key space in order, writing them one
+ * after another yields a single sorted file.
+ */
+class OpeningTreeBuilder {
+public:
+   static const unsigned shardBits = 8;
+
+private:
+   struct Shard {
+      std::mutex mutex;
+      // games == 0 marks an empty slot
+      std::vector<TreeRecord> table;
+      unsigned count;
+      std::vector<std::string> runs;
+      Shard (): count(0) {}
+   };
+   Shard _shards[1 << shardBits];
+   unsigned _capacity;
+   std::string _path;
+   bool _failed;
+
+   OpeningTreeBuilder (OpeningTreeBuilder const&);
+   void operator= (OpeningTreeBuilder const&);
+
+public:
+   // the index will be written to path; memory is the budget in bytes
+   OpeningTreeBuilder (char const* path, unsigned long long memory);
+   // removes any runs write() didn't get to
+   ~OpeningTreeBuilder ();
+
+   // thread safe; records needn't be sorted and may repeat
+   void add (TreeRecord* records, unsigned count);
+   // returns the number of records written, or -1 on failure
+   long long write ();
+   unsigned runs () const;
+
+private:
+   void insert (Shard& shard, unsigned index, TreeRecord const& r);
+   bool spill (Shard& shard, unsigned index);
+   void removeRuns ();
+};
+
+//------------------------------------------------------------------------------
+// Feeds a builder the first plies of every finished game it's shown. Use one
+// per thread; records are handed over in batches.
+class TreeCollector: public PgnObserver {
+private:
+   OpeningTreeBuilder& _builder;
+   unsigned _plies;
+   int _result;   // 1 light won, -1 dark won, 0 drawn, 2 unknown
+   std::vector<TreeRecord> _batch;
+
+public:
+   TreeCollector (OpeningTreeBuilder& builder, unsigned plies):
+      _builder(builder), _plies(plies), _result(2) {}
+   ~TreeCollector () { flush(); }
+
+   void tag (char const* name, unsigned nameLength, char const* value, unsigned valueLength);
+   void gameFinished (Game const& game, bool ok);
+   void flush ();
+};
+
+
+//==============================================================================
+// Opening Tree
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// A mapped tree index: a 16 byte header, then records sorted by key and move.
+// A lookup is a binary search over the mapping and allocates nothing.
+class OpeningTree {
+private:
+   MappedFile _file;
+   TreeRecord const* _records;
+   unsigned long long _size;
+
+public:
+   OpeningTree (): _records(0), _size(0) {}
+   bool open (char const* path);
+   void close () { _file.close(); _records = 0; _size = 0; }
+   bool isOpen () const { return _records != 0; }
+   unsigned long long size () const { return _size; }
+
+   // the moves recorded for key; returns how many there are
+   unsigned find (HashKey key, TreeRecord const*& first) const;
+   unsigned find (Board const& b, TreeRecord const*& first) const;
+};
+
+
+#endif
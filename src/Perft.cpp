@@ -0,0 +1,195 @@
+//==============================================================================
+// Perft.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Perft.h"
+#include "Search.h"
+
+
+//==============================================================================
+// Perft Table
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void PerftTable::resize (unsigned megabytes) {
+   unsigned long long bytes = static_cast<unsigned long long>(megabytes) << 20;
+   unsigned long long count = 1;
+   while ((count << 1) * sizeof(Slot) <= bytes)
+      count <<= 1;
+   delete[] slots;
+   slots = new Slot[count];
+   mask = count - 1;
+   clear();
+}
+
+//------------------------------------------------------------------------------
+void PerftTable::clear () {
+   for (unsigned long long i=0; i<=mask; ++i) {
+      slots[i].check.store(0, std::memory_order_relaxed);
+      slots[i].count.store(0, std::memory_order_relaxed);
+   }
+}
+
+//------------------------------------------------------------------------------
+// positionKey records which special moves are possible now, not the castling
+// rights that decide them further down the tree, so the flags go in as well.
+// The pawn that just advanced two only matters if it can be taken.
+HashKey PerftTable::key (Board const& b, unsigned depth) {
+   PathDependence const& pd = b.pathDependence();
+   SpecialMoves const& sm = b.specialMoves();
+   unsigned long long state = pd.packedFlags();
+   if (sm.canEnPassantLeft() || sm.canEnPassantRight())
+      state |= pd.pawnFile() << 8;
+   else
+      state &= ~0x2u;
+   state |= static_cast<unsigned long long>(depth) << 12;
+   return positionKey(b) ^ (state * 0x9e3779b97f4a7c15ull);
+}
+
+//------------------------------------------------------------------------------
+bool PerftTable::probe (Board const& b, unsigned depth, unsigned long long& count) const {
+   HashKey k = key(b, depth);
+   Slot const& slot = slots[k & mask];
+   unsigned long long c = slot.count.load(std::memory_order_relaxed);
+   unsigned long long check = slot.check.load(std::memory_order_relaxed);
+   if ((check ^ c) != k || c == 0)
+      return false;
+   count = c;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void PerftTable::store (Board const& b, unsigned depth, unsigned long long count) {
+   HashKey k = key(b, depth);
+   Slot& slot = slots[k & mask];
+   slot.check.store(k ^ count, std::memory_order_relaxed);
+   slot.count.store(count, std::memory_order_relaxed);
+}
+
+
+//==============================================================================
+// Perft
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// The legal moves by brute force, in the same order as generateLegalMoves.
+void referenceMoves (Board const& b, MoveList& list) {
+   PathIndependentArbiter arbiter;
+   MoveList pseudo;
+   generatePseudoLegalMoves(b, pseudo);
+
+   list.clear();
+   bool light = b.pathDependence().lightMove();
+   Board child;
+   for (unsigned i=0; i<pseudo.size; ++i) {
+      b.realize(pseudo[i], child);
+      if (!arbiter.isInCheck(child.bitboard(), light))
+         list.push(pseudo[i]);
+   }
+}
+
+//------------------------------------------------------------------------------
+bool contains (MoveList const& list, Move const& m) {
+   for (unsigned i=0; i<list.size; ++i) {
+      if (list[i] == m)
+         return true;
+   }
+   return false;
+}
+
+}
+
+//------------------------------------------------------------------------------
+unsigned long long Perft::count (Board const& b, unsigned depth, PerftTable* table) {
+   if (depth == 0)
+      return 1;
+   unsigned long long total;
+   if (depth > 1 && table && table->probe(b, depth, total))
+      return total;
+   MoveList list;
+   generateLegalMoves(b, list);
+   if (depth == 1)
+      return list.size;
+
+   total = 0;
+   Board child;
+   for (unsigned i=0; i<list.size; ++i) {
+      b.realize(list[i], child);
+      total += count(child, depth - 1, table);
+   }
+   if (table)
+      table->store(b, depth, total);
+   return total;
+}
+
+//------------------------------------------------------------------------------
+unsigned long long Perft::divide (Board const& b, unsigned depth, MoveList& moves,
+                                  unsigned long long* counts, PerftTable* table) {
+   generateLegalMoves(b, moves);
+   unsigned long long total = 0;
+   Board child;
+   for (unsigned i=0; i<moves.size; ++i) {
+      b.realize(moves[i], child);
+      counts[i] = count(child, depth - 1, table);
+      total += counts[i];
+   }
+   return total;
+}
+
+//------------------------------------------------------------------------------
+unsigned long long Perft::reference (Board const& b, unsigned depth) {
+   if (depth == 0)
+      return 1;
+   MoveList list;
+   referenceMoves(b, list);
+   unsigned long long total = 0;
+   Board child;
+   for (unsigned i=0; i<list.size; ++i) {
+      b.realize(list[i], child);
+      total += reference(child, depth - 1);
+   }
+   return total;
+}
+
+//------------------------------------------------------------------------------
+bool Perft::findDivergence (Board const& b, unsigned depth, MoveList& path,
+                            MoveList& missing, MoveList& extra) {
+   path.clear();
+   missing.clear();
+   extra.clear();
+   Board boards[2];
+   boards[0] = b;
+   for (unsigned n=0; depth > 0; ++n, --depth) {
+      Board const& node = boards[n & 1];
+      MoveList fast, slow;
+      generateLegalMoves(node, fast);
+      referenceMoves(node, slow);
+      for (unsigned i=0; i<slow.size; ++i) {
+         if (!contains(fast, slow[i]))
+            missing.push(slow[i]);
+      }
+      for (unsigned i=0; i<fast.size; ++i) {
+         if (!contains(slow, fast[i]))
+            extra.push(fast[i]);
+      }
+      if (missing.size || extra.size)
+         return true;
+      if (depth == 1)
+         return false;
+
+      unsigned i = 0;
+      Board& child = boards[(n + 1) & 1];
+      for ( ; i<fast.size; ++i) {
+         node.realize(fast[i], child);
+         if (count(child, depth - 1) != reference(child, depth - 1))
+            break;
+      }
+      if (i == fast.size)
+         return false;
+      path.push(fast[i]);
+   }
+   return false;
+}
@@ -0,0 +1,84 @@
+//==============================================================================
+// Perft.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef PERFT
+#define PERFT
+
+#include <atomic>
+#include "Chess.h"
+
+
+//==============================================================================
+// Perft Table
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Subtree counts keyed by position and depth, shared by any number of threads.
+/*
+ * Slots are single and always replace, and hold the key xored with the count
+ * as TranspositionTable's do, so a torn slot fails to match rather than
+ * giving a wrong count. The size is rounded down to a power of two.
+ */
+class PerftTable {
+private:
+   struct Slot {
+      std::atomic<unsigned long long> check;
+      std::atomic<unsigned long long> count;
+   };
+   Slot* slots;
+   unsigned long long mask;
+
+   PerftTable (PerftTable const&);
+   void operator= (PerftTable const&);
+
+public:
+   PerftTable (unsigned megabytes = 16): slots(0), mask(0) { resize(megabytes); }
+   ~PerftTable () { delete[] slots; }
+   void resize (unsigned megabytes);
+   void clear ();
+
+   bool probe (Board const& b, unsigned depth, unsigned long long& count) const;
+   void store (Board const& b, unsigned depth, unsigned long long count);
+
+private:
+   static HashKey key (Board const& b, unsigned depth);
+};
+
+
+//==============================================================================
+// Perft
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Counts the leaves of the legal move tree, to check the move generator
+// against known counts.
+/*
+ * Leaves are never realized: a node one ply above them counts the size of its
+ * legal move list. With a table, subtrees of depth 2 or more are looked up
+ * before they are walked, so transpositions are counted once.
+ */
+namespace Perft {
+   unsigned long long count (Board const& b, unsigned depth, PerftTable* table = 0);
+
+   // counts[i] is the count below moves[i] (in generateLegalMoves order);
+   // returns their sum. depth must be at least 1.
+   unsigned long long divide (Board const& b, unsigned depth, MoveList& moves,
+                              unsigned long long* counts, PerftTable* table = 0);
+
+   // The same count the slow way: every pseudo legal move is realized and
+   // tested with isInCheck, leaves included, so none of generateLegalMoves'
+   // shortcuts are trusted.
+   unsigned long long reference (Board const& b, unsigned depth);
+
+   // Follows the first move on which count and reference disagree down to
+   // depth 1. path gets the moves leading there; missing and extra get the
+   // legal moves that generateLegalMoves leaves out or makes up where the
+   // move lists themselves differ. Returns false if the two agree.
+   bool findDivergence (Board const& b, unsigned depth, MoveList& path,
+                        MoveList& missing, MoveList& extra);
+}
+
+
+#endif
@@ -0,0 +1,330 @@
+//==============================================================================
+// Pgn.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Pgn.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "Fen.h"
+#include "San.h"
+#include "Trace.h"
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+inline bool isSpace (char c) {
+   return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+//------------------------------------------------------------------------------
+// Characters that end a movetext symbol.
+inline bool isDelimiter (char c) {
+   return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')'
+       || c == '[' || c == ']' || c == ';' || c == '$';
+}
+
+//------------------------------------------------------------------------------
+inline char const* skipLine (char const* p, char const* end) {
+   while (p < end && *p != '\n')
+      ++p;
+   return p;
+}
+
+//------------------------------------------------------------------------------
+inline char const* skipComment (char const* p, char const* end) {
+   while (p < end && *p != '}')
+      ++p;
+   return p < end ? p + 1 : p;
+}
+
+//------------------------------------------------------------------------------
+// Skips a variation (and any nested in it), starting just after its '('.
+char const* skipVariation (char const* p, char const* end) {
+   unsigned depth = 1;
+   while (p < end && depth) {
+      switch (*p) {
+      case '(': ++depth; ++p; break;
+      case ')': --depth; ++p; break;
+      case '{': p = skipComment(p + 1, end); break;
+      case ';': p = skipLine(p, end); break;
+      default: ++p;
+      }
+   }
+   return p;
+}
+
+//------------------------------------------------------------------------------
+inline bool equals (char const* begin, char const* end, char const* text) {
+   unsigned length = strlen(text);
+   return static_cast<unsigned>(end - begin) == length && strncmp(begin, text, length) == 0;
+}
+
+//------------------------------------------------------------------------------
+inline bool isResult (char const* begin, char const* end) {
+   return equals(begin, end, "1-0") || equals(begin, end, "0-1")
+       || equals(begin, end, "1/2-1/2") || equals(begin, end, "*");
+}
+
+//------------------------------------------------------------------------------
+void readRange (PgnReader* reader, char const* begin, char const* end) {
+   reader->read(begin, end);
+}
+
+}
+
+
+//==============================================================================
+// PGN Reader
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void PgnStats::addEnding (Board const& last) {
+   if (hasLegalMove(last))
+      return;
+   PathIndependentArbiter arbiter;
+   if (arbiter.isInCheck(last.bitboard(), last.pathDependence().lightMove()))
+      ++checkmates;
+   else
+      ++stalemates;
+}
+
+//------------------------------------------------------------------------------
+void PgnReader::read (char const* begin, char const* end) {
+   Trace::Scope scope("pgn", "parse", end - begin);
+   char const* p = begin;
+   while (p < end)
+      p = readGame(p, end);
+   _stats.bytes += end - begin;
+}
+
+//------------------------------------------------------------------------------
+bool PgnReader::read (int fd) {
+   // complete games are read out of the buffer as soon as the next one starts;
+   // it only grows if a single game doesn't fit
+   std::vector<char> buffer(1 << 20);
+   unsigned long long used = 0;
+   while (true) {
+      if (used == buffer.size())
+         buffer.resize(2 * buffer.size());
+      ssize_t n;
+      {
+         Trace::Scope scope("io", "read");
+         n = ::read(fd, &buffer[used], buffer.size() - used);
+         scope.setArg(n);
+      }
+      if (n < 0)
+         return false;
+      char const* begin = &buffer[0];
+      if (n == 0) {
+         read(begin, begin + used);
+         return true;
+      }
+      used += n;
+
+      // keep the last (possibly incomplete) game for the next round
+      char const* split = begin + used;
+      for (char const* p = Pgn::nextGame(begin + 1, begin + used); p < begin + used;
+           p = Pgn::nextGame(p + 1, begin + used)) {
+         split = p;
+      }
+      if (split == begin + used)
+         continue;
+      read(begin, split);
+      used = begin + used - split;
+      memmove(&buffer[0], split, used);
+   }
+}
+
+//------------------------------------------------------------------------------
+// The tags run until the first movetext symbol, and the movetext until a
+// result or the start of the next game's tags.
+char const* PgnReader::readGame (char const* p, char const* end) {
+   _start.setupNewGame();
+   bool seen = false;
+   bool started = false;
+   bool ok = true;
+   bool lineStart = true;
+
+   while (p < end) {
+      char c = *p;
+      if (isSpace(c)) {
+         lineStart = c == '\n';
+         ++p;
+         continue;
+      }
+      // escape lines are ignored
+      if (c == '%' && lineStart) {
+         p = skipLine(p, end);
+         continue;
+      }
+      lineStart = false;
+
+      if (c == '[') {
+         // a new game's tags (the last game had no result)
+         if (started)
+            break;
+         seen = true;
+         char const* name = ++p;
+         while (p < end && !isSpace(*p) && *p != '"' && *p != ']')
+            ++p;
+         char const* nameEnd = p;
+         while (p < end && *p != '"' && *p != ']')
+            ++p;
+         char const* value = p;
+         char const* valueEnd = p;
+         if (p < end && *p == '"') {
+            value = ++p;
+            while (p < end && *p != '"') {
+               if (*p == '\\' && p + 1 < end)
+                  ++p;
+               ++p;
+            }
+            valueEnd = p;
+         }
+         while (p < end && *p != ']' && *p != '\n')
+            ++p;
+         if (p < end && *p == ']')
+            ++p;
+
+         if (_observer)
+            _observer->tag(name, nameEnd - name, value, valueEnd - value);
+         if (equals(name, nameEnd, "FEN") && !Fen::read(value, valueEnd, _start))
+            ok = false;
+         continue;
+      }
+      if (c == '{') {
+         p = skipComment(p + 1, end);
+         continue;
+      }
+      if (c == ';') {
+         p = skipLine(p, end);
+         continue;
+      }
+      if (c == '(') {
+         p = skipVariation(p + 1, end);
+         continue;
+      }
+      if (c == ')' || c == ']' || c == '}') {
+         ++p;
+         continue;
+      }
+      if (c == '$') {
+         ++p;
+         while (p < end && '0' <= *p && *p <= '9')
+            ++p;
+         continue;
+      }
+
+      // a movetext symbol
+      char const* token = p;
+      while (p < end && !isDelimiter(*p))
+         ++p;
+      seen = true;
+      if (!started) {
+         started = true;
+         _game.setPosition(_start);
+         if (_observer)
+            _observer->gameStarted(_start);
+      }
+      if (isResult(token, p))
+         break;
+
+      // move numbers may be glued to the move (ex, "12.Nf3" or "12...Nf3")
+      if ('1' <= *token && *token <= '9') {
+         while (token < p && '0' <= *token && *token <= '9')
+            ++token;
+      }
+      while (token < p && *token == '.')
+         ++token;
+      if (token == p || equals(token, p, "e.p."))
+         continue;
+
+      if (ok && !playMove(token, p))
+         ok = false;
+   }
+
+   if (seen) {
+      if (!started)
+         _game.setPosition(_start);
+      ++_stats.games;
+      if (ok)
+         _stats.addEnding(_game.currentBoard());
+      else
+         ++_stats.errors;
+      if (_observer)
+         _observer->gameFinished(_game, ok);
+   }
+   return p;
+}
+
+//------------------------------------------------------------------------------
+bool PgnReader::playMove (char const* begin, char const* end) {
+   Move m;
+   if (San::resolve(_game.currentBoard(), begin, end, m) != San::ok)
+      return false;
+   _game.move(m);
+   ++_stats.moves;
+   if (_observer)
+      _observer->movePlayed(_game, m);
+   return true;
+}
+
+
+//==============================================================================
+// Parallel Replay
+//==============================================================================
+
+//------------------------------------------------------------------------------
+char const* Pgn::nextGame (char const* p, char const* end) {
+   static char const tag[] = "[Event ";
+   static unsigned const length = sizeof(tag) - 1;
+   for ( ; p + length <= end; ++p) {
+      p = static_cast<char const*>(memchr(p, '[', end - p));
+      if (!p)
+         return end;
+      if (p + length <= end && memcmp(p, tag, length) == 0)
+         return p;
+   }
+   return end;
+}
+
+//------------------------------------------------------------------------------
+PgnStats Pgn::replay (char const* begin, char const* end, unsigned threads,
+                      PgnObserver* const* observers) {
+   if (threads == 0)
+      threads = 1;
+
+   // split evenly by size, then move each split forward to a game boundary
+   std::vector<char const*> splits(threads + 1, end);
+   splits[0] = begin;
+   for (unsigned i=1; i<threads; ++i) {
+      char const* target = begin + (end - begin) * i / threads;
+      if (target < splits[i - 1])
+         target = splits[i - 1];
+      splits[i] = nextGame(target, end);
+   }
+
+   std::vector<PgnReader> readers(threads);
+   std::vector<std::thread> workers;
+   for (unsigned i=0; i<threads; ++i) {
+      readers[i].setObserver(observers ? observers[i] : 0);
+      if (i)
+         workers.push_back(std::thread(readRange, &readers[i], splits[i], splits[i + 1]));
+   }
+   readers[0].read(splits[0], splits[1]);
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+
+   PgnStats total;
+   for (unsigned i=0; i<threads; ++i)
+      total.add(readers[i].stats());
+   return total;
+}
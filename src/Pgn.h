@@ -0,0 +1,105 @@
+//==============================================================================
+// Pgn.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef PGN
+#define PGN
+
+#include "Chess.h"
+
+
+//==============================================================================
+// PGN Observer
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Receives the games a PgnReader replays. Every method does nothing by default.
+class PgnObserver {
+public:
+   virtual ~PgnObserver () {}
+   // a tag pair (ex, [White "Morphy"]); value has its escapes still in place
+   virtual void tag (char const* name, unsigned nameLength,
+                     char const* value, unsigned valueLength) {}
+   // the tags are done and the first move is next
+   virtual void gameStarted (Board const& start) {}
+   // a main line move has been played; game.currentBoard() is the new position
+   virtual void movePlayed (Game const& game, Move const& move) {}
+   // ok is false if the game stopped at a move that couldn't be resolved
+   virtual void gameFinished (Game const& game, bool ok) {}
+};
+
+
+//==============================================================================
+// PGN Reader
+//==============================================================================
+
+//------------------------------------------------------------------------------
+struct PgnStats {
+   unsigned long long games;
+   unsigned long long moves;
+   // games cut short by an unreadable or illegal move (or a bad FEN tag)
+   unsigned long long errors;
+   unsigned long long bytes;
+   // games whose last position is mate or stalemate
+   unsigned long long checkmates;
+   unsigned long long stalemates;
+
+   PgnStats (): games(0), moves(0), errors(0), bytes(0), checkmates(0), stalemates(0) {}
+   void add (PgnStats const& s) {
+      games += s.games; moves += s.moves; errors += s.errors; bytes += s.bytes;
+      checkmates += s.checkmates; stalemates += s.stalemates;
+   }
+   // counts a finished game's last position if it has no legal moves
+   void addEnding (Board const& last);
+};
+
+//------------------------------------------------------------------------------
+// Replays the main line of every game in PGN text through one reused Game.
+/*
+ * The tokenizer works in place on a [begin, end) range: comments, variations,
+ * NAGs and move numbers are skipped, SAN is resolved by generating only the
+ * moves of the pieces it could name, and nothing is allocated per move. A
+ * reader is used by one thread at a time; Pgn::replay runs one per thread.
+ */
+class PgnReader {
+private:
+   Game _game;
+   Board _start;
+   PgnObserver* _observer;
+   PgnStats _stats;
+
+public:
+   PgnReader (): _observer(0) {}
+   void setObserver (PgnObserver* observer) { _observer = observer; }
+   PgnStats const& stats () const { return _stats; }
+   void resetStats () { _stats = PgnStats(); }
+
+   // reads every game in [begin, end)
+   void read (char const* begin, char const* end);
+   // reads a descriptor (ex, a pipe) in chunks until end of file; returns
+   // false on a read error
+   bool read (int fd);
+   // reads the game starting at p and returns the end of it
+   char const* readGame (char const* p, char const* end);
+
+private:
+   bool playMove (char const* begin, char const* end);
+};
+
+
+//==============================================================================
+// Parallel Replay
+//==============================================================================
+
+namespace Pgn {
+   // the first game that starts (with an Event tag) at or after p, or end
+   char const* nextGame (char const* p, char const* end);
+   // replays [begin, end) split at game boundaries over the given number of
+   // threads; observers, if given, holds one observer per thread
+   PgnStats replay (char const* begin, char const* end, unsigned threads,
+                    PgnObserver* const* observers = 0);
+}
+
+
+#endif
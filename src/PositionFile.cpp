@@ -0,0 +1,153 @@
+//==============================================================================
+// PositionFile.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "PositionFile.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// The header is the magic number, then the version and the record size (both
+// 32 bit), then 4 reserved bytes.
+char const magic[4] = { 'G', 'P', 'O', 'S' };
+unsigned const version = 1;
+
+//------------------------------------------------------------------------------
+// Clears the data codes in a word of nibbles: piece codes (4 to 15) have bit 2
+// or bit 3 set, data codes (0 to 3) have neither.
+inline unsigned piecesOnly (unsigned w) {
+   unsigned pieces = ((w >> 2) | (w >> 3)) & 0x11111111u;
+   return w & (pieces * 0xfu);
+}
+
+//------------------------------------------------------------------------------
+inline unsigned short clamp16 (unsigned n) {
+   return n < 0xffff ? n : 0xffff;
+}
+
+//------------------------------------------------------------------------------
+void scanRange (PositionFile const* file, unsigned long long begin, unsigned long long end,
+                PositionVisitor* visitor) {
+   file->scan(begin, end, *visitor);
+}
+
+}
+
+
+//==============================================================================
+// Position Record
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void PositionRecord::pack (Board const& b) {
+   unsigned const* w = b.bitboard().words();
+   for (unsigned i=0; i<8; ++i)
+      word[i] = piecesOnly(w[i]);
+   PathDependence const& pd = b.pathDependence();
+   flags = pd.packedFlags();
+   pawnFile = pd.pawnFile();
+   halfmoveClock = clamp16(pd.halfmoveClock());
+   fullmoveNumber = clamp16(pd.fullmoveNumber());
+   reserved = 0;
+}
+
+//------------------------------------------------------------------------------
+void PositionRecord::unpack (Board& b) const {
+   b.b.setWords(word);
+   b.pd.setPackedFlags(flags, pawnFile);
+   b.pd.setClocks(halfmoveClock, fullmoveNumber);
+   b.finishSetup();
+}
+
+
+//==============================================================================
+// Position Writer
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool PositionWriter::open (char const* path) {
+   close();
+   _file = std::fopen(path, "wb");
+   if (!_file)
+      return false;
+   // records are small, so buffer plenty of them per write(2)
+   std::setvbuf(_file, 0, _IOFBF, 1 << 20);
+   unsigned header[4] = { 0, version, sizeof(PositionRecord), 0 };
+   memcpy(header, magic, 4);
+   _count = 0;
+   return std::fwrite(header, sizeof(header), 1, _file) == 1;
+}
+
+//------------------------------------------------------------------------------
+bool PositionWriter::write (Board const& b) {
+   PositionRecord record;
+   record.pack(b);
+   if (std::fwrite(&record, sizeof(record), 1, _file) != 1)
+      return false;
+   ++_count;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+bool PositionWriter::close () {
+   if (!_file)
+      return true;
+   bool ok = std::fclose(_file) == 0;
+   _file = 0;
+   return ok;
+}
+
+
+//==============================================================================
+// Position File
+//==============================================================================
+
+//------------------------------------------------------------------------------
+bool PositionFile::open (char const* path) {
+   close();
+   if (!_file.open(path))
+      return false;
+   unsigned header[4] = { 0, 0, 0, 0 };
+   if (_file.size() >= headerSize)
+      memcpy(header, _file.begin(), headerSize);
+   if (memcmp(header, magic, 4) != 0 || header[1] != version
+       || header[2] != sizeof(PositionRecord)
+       || (_file.size() - headerSize) % sizeof(PositionRecord) != 0) {
+      _file.close();
+      return false;
+   }
+   // the mapping is page aligned, so records after a 16 byte header are aligned too
+   _records = reinterpret_cast<PositionRecord const*>(_file.begin() + headerSize);
+   _size = (_file.size() - headerSize) / sizeof(PositionRecord);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+void PositionFile::scan (unsigned long long begin, unsigned long long end,
+                         PositionVisitor& visitor) const {
+   for (unsigned long long i=begin; i<end; ++i)
+      visitor.visit(i, _records[i]);
+}
+
+//------------------------------------------------------------------------------
+void PositionFile::scan (unsigned threads, PositionVisitor* const* visitors) const {
+   if (threads == 0)
+      threads = 1;
+   std::vector<std::thread> workers;
+   for (unsigned i=1; i<threads; ++i) {
+      workers.push_back(std::thread(scanRange, this, _size * i / threads,
+                                    _size * (i + 1) / threads, visitors[i]));
+   }
+   scan(0, _size / threads, *visitors[0]);
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+}
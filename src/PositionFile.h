@@ -0,0 +1,109 @@
+//==============================================================================
+// PositionFile.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef POSITIONFILE
+#define POSITIONFILE
+
+#include <cstdio>
+#include "Chess.h"
+#include "MappedFile.h"
+
+
+//==============================================================================
+// Position Record
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// A position in 40 bytes: the BitBoard nibbles, then the path dependent state.
+/*
+ * The nibbles are stored with the hash state cleared (every empty square is
+ * PC::c0), so equal positions have equal records. Words are in the machine's
+ * byte order; files are not meant to move between big and little endian hosts.
+ * A record can be read in place (a view) or expanded into a full Board.
+ */
+struct PositionRecord {
+   unsigned word[8];
+   unsigned char flags;        // PathDependence flags
+   unsigned char pawnFile;     // file of the double advanced pawn, if any
+   unsigned short halfmoveClock;
+   unsigned short fullmoveNumber;
+   unsigned short reserved;    // zero; keeps records a multiple of 8 bytes
+
+   void pack (Board const& b);
+   void unpack (Board& b) const;
+
+   Piece get (Square s) const { return (word[s >> 3] >> ((s & 7) << 2)) & 0xfu; }
+   bool lightMove () const { return flags & 0x1; }
+};
+
+
+//==============================================================================
+// Position Writer
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Appends records to a position file (buffered by stdio).
+class PositionWriter {
+private:
+   std::FILE* _file;
+   unsigned long long _count;
+
+   PositionWriter (PositionWriter const&);
+   void operator= (PositionWriter const&);
+
+public:
+   PositionWriter (): _file(0), _count(0) {}
+   ~PositionWriter () { close(); }
+
+   // creates (or truncates) the file and writes its header
+   bool open (char const* path);
+   // returns false if the file couldn't be written (also check close)
+   bool write (Board const& b);
+   bool close ();
+   unsigned long long count () const { return _count; }
+};
+
+
+//==============================================================================
+// Position File
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Receives records during a scan. One visitor is used by one thread.
+class PositionVisitor {
+public:
+   virtual ~PositionVisitor () {}
+   virtual void visit (unsigned long long index, PositionRecord const& record) = 0;
+};
+
+//------------------------------------------------------------------------------
+// A mapped position file: records are read in place, without copying.
+class PositionFile {
+private:
+   MappedFile _file;
+   PositionRecord const* _records;
+   unsigned long long _size;
+
+public:
+   static const unsigned headerSize = 16;
+
+   PositionFile (): _records(0), _size(0) {}
+   // fails if the file isn't a position file
+   bool open (char const* path);
+   void close () { _file.close(); _records = 0; _size = 0; }
+
+   unsigned long long size () const { return _size; }
+   PositionRecord const& operator[] (unsigned long long i) const { return _records[i]; }
+   void board (unsigned long long i, Board& b) const { _records[i].unpack(b); }
+
+   // visits every record in order, split into contiguous ranges over the
+   // given number of threads; visitors holds one visitor per thread
+   void scan (unsigned threads, PositionVisitor* const* visitors) const;
+   // visits records [begin, end) on the calling thread
+   void scan (unsigned long long begin, unsigned long long end, PositionVisitor& visitor) const;
+};
+
+
+#endif
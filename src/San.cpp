@@ -0,0 +1,230 @@
+//==============================================================================
+// San.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "San.h"
+#include <cstring>
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// What a move's text says about it. -1 means "not given".
+struct Pattern {
+   int piece;        // offset from the pawn code (0 pawn, 1 knight, ... 5 king)
+   int fromFile;
+   int fromRank;
+   int to;
+   unsigned kind;    // Move::basic, a promotion, or a castle
+};
+
+//------------------------------------------------------------------------------
+inline bool isFile (char c) { return 'a' <= c && c <= 'h'; }
+inline bool isRank (char c) { return '1' <= c && c <= '8'; }
+
+//------------------------------------------------------------------------------
+// Offset of a piece letter from the pawn code, or -1. Lower case letters are
+// only accepted where they can't be mistaken for files (promotions).
+inline int pieceOffset (char c, bool lower) {
+   switch (c) {
+   case 'N': return 1;
+   case 'B': return 2;
+   case 'R': return 3;
+   case 'Q': return 4;
+   case 'K': return 5;
+   }
+   if (lower) {
+      switch (c) {
+      case 'n': return 1;
+      case 'b': return 2;
+      case 'r': return 3;
+      case 'q': return 4;
+      }
+   }
+   return -1;
+}
+
+//------------------------------------------------------------------------------
+// Reads [p, end) from both ends in one pass. Returns false if it isn't
+// algebraic notation.
+bool parse (char const* p, char const* end, Pattern& pat) {
+   // check marks and annotations carry nothing we need
+   while (end > p && (end[-1] == '+' || end[-1] == '#' || end[-1] == '!' || end[-1] == '?'))
+      --end;
+
+   pat.piece = 0;
+   pat.fromFile = -1;
+   pat.fromRank = -1;
+   pat.to = -1;
+   pat.kind = Move::basic;
+
+   // castling (some writers use zeros)
+   unsigned length = end - p;
+   if ((length == 3 || length == 5) && (p[0] == 'O' || p[0] == '0')) {
+      for (unsigned i=0; i<length; ++i) {
+         if (p[i] != ((i & 1) ? '-' : p[0]))
+            return false;
+      }
+      pat.piece = 5;
+      pat.kind = length == 3 ? Move::castleShort : Move::castleLong;
+      return true;
+   }
+
+   // promotion suffix: "=Q", "Q", or (coordinates) "q"
+   if (end - p >= 3) {
+      int promoted = pieceOffset(end[-1], isRank(end[-2]));
+      if (1 <= promoted && promoted <= 4) {
+         pat.kind = Move::promoteKnight + promoted - 1;
+         --end;
+         if (end[-1] == '=')
+            --end;
+      }
+   }
+
+   // destination square
+   if (end - p < 2 || !isFile(end[-2]) || !isRank(end[-1]))
+      return false;
+   pat.to = ((end[-1] - '1') << 3) + (end[-2] - 'a');
+   end -= 2;
+
+   // piece letter, then the source (in full for LAN), then a capture mark
+   bool letter = false;
+   if (p < end && pieceOffset(*p, false) > 0) {
+      pat.piece = pieceOffset(*p++, false);
+      letter = true;
+   }
+   if (p < end && (end[-1] == 'x' || end[-1] == '-' || end[-1] == ':'))
+      --end;
+   if (p < end && isFile(*p))
+      pat.fromFile = *p++ - 'a';
+   if (p < end && isRank(*p))
+      pat.fromRank = *p++ - '1';
+   if (p != end)
+      return false;
+
+   // only pawns promote
+   if (pat.kind != Move::basic && pat.piece != 0)
+      return false;
+   // bare coordinates name the source square, whatever stands there
+   if (!letter && pat.fromFile >= 0 && pat.fromRank >= 0 && pat.kind == Move::basic)
+      pat.piece = -1;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Whether m (of the given moving piece) fits the pattern.
+inline bool fits (Pattern const& pat, Move const& m, Piece moving, Piece piece) {
+   if (pat.kind == Move::castleShort || pat.kind == Move::castleLong)
+      return m.kind == pat.kind;
+   if (m.dst != pat.to)
+      return false;
+   if (pat.piece >= 0 && moving != piece)
+      return false;
+   // castling by its king move is only written as coordinates (ex, "e1g1")
+   if (m.isCastle() && pat.piece != -1)
+      return false;
+   // en passant is written like any other pawn capture
+   if (m.isPromotion() ? m.kind != pat.kind : pat.kind != Move::basic)
+      return false;
+   if (pat.fromFile >= 0 && (m.src & 7) != pat.fromFile)
+      return false;
+   if (pat.fromRank >= 0 && (m.src >> 3) != pat.fromRank)
+      return false;
+   return true;
+}
+
+//------------------------------------------------------------------------------
+inline San::Status status (unsigned matches) {
+   if (matches == 0)
+      return San::illegal;
+   return matches == 1 ? San::ok : San::ambiguous;
+}
+
+}
+
+
+//==============================================================================
+// Algebraic Notation
+//==============================================================================
+
+//------------------------------------------------------------------------------
+San::Status San::resolve (Board const& b, char const* begin, char const* end, Move& move) {
+   Pattern pat;
+   if (!parse(begin, end, pat))
+      return unreadable;
+
+   BitBoard const& bb = b.bitboard();
+   bool light = b.pathDependence().lightMove();
+   Piece piece = (light ? PC::p0 : PC::p1) + pat.piece;
+   Generator gen;
+   gen.setBoard(b);
+   PathIndependentArbiter arbiter;
+   Board child;
+   unsigned matches = 0;
+
+   // only pieces that could have made the move are generated
+   PieceItr itr(bb, light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      Square src = itr.square();
+      if (pat.piece >= 0 && itr.piece() != piece)
+         continue;
+      if (pat.fromFile >= 0 && (src & 7) != static_cast<Square>(pat.fromFile))
+         continue;
+      if (pat.fromRank >= 0 && (src >> 3) != static_cast<Square>(pat.fromRank))
+         continue;
+      for (gen.setSource(src); gen.valid(); ++gen) {
+         Move m = gen.move();
+         if (!fits(pat, m, itr.piece(), piece))
+            continue;
+         b.realize(m, child);
+         if (arbiter.isInCheck(child.bitboard(), light))
+            continue;
+         move = m;
+         ++matches;
+      }
+   }
+   return status(matches);
+}
+
+//------------------------------------------------------------------------------
+San::Status San::resolve (Board const& b, char const* text, Move& move) {
+   return resolve(b, text, text + strlen(text), move);
+}
+
+//------------------------------------------------------------------------------
+San::Status San::resolve (Board const& b, MoveList const& legal,
+                          char const* begin, char const* end, Move& move) {
+   Pattern pat;
+   if (!parse(begin, end, pat))
+      return unreadable;
+
+   BitBoard const& bb = b.bitboard();
+   Piece piece = (b.pathDependence().lightMove() ? PC::p0 : PC::p1) + pat.piece;
+   unsigned matches = 0;
+   for (unsigned i=0; i<legal.size; ++i) {
+      if (fits(pat, legal[i], bb.get(legal[i].src), piece)) {
+         move = legal[i];
+         ++matches;
+      }
+   }
+   return status(matches);
+}
+
+//------------------------------------------------------------------------------
+unsigned San::resolve (Board const& b, char const* const* begins, char const* const* ends,
+                       unsigned count, Move* moves, Status* statuses) {
+   MoveList legal;
+   generateLegalMoves(b, legal);
+   unsigned resolved = 0;
+   for (unsigned i=0; i<count; ++i) {
+      statuses[i] = resolve(b, legal, begins[i], ends[i], moves[i]);
+      if (statuses[i] == ok)
+         ++resolved;
+   }
+   return resolved;
+}
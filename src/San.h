@@ -0,0 +1,51 @@
+//==============================================================================
+// San.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef SAN
+#define SAN
+
+#include "Chess.h"
+
+
+//==============================================================================
+// Algebraic Notation
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Resolves moves written in standard or long algebraic notation.
+/*
+ * Accepted forms include SAN ("Nbd7", "exd6", "O-O-O", "e8=Q+"), LAN
+ * ("Ng1-f3", "e4xd5", "e7-e8=Q") and coordinates ("g1f3", "e1g1", "e7e8q").
+ * Check marks and annotations ("+", "#", "!", "?") are ignored. Text is read
+ * from a [begin, end) range and nothing is allocated.
+ *
+ * A move that fits more than one legal move (ex, "Nd7" when both knights can
+ * go there) is reported as ambiguous rather than resolved to whichever was
+ * generated first.
+ */
+namespace San {
+   enum Status {
+      ok,           // move holds the one legal move the text describes
+      unreadable,   // the text isn't algebraic notation
+      illegal,      // no legal move fits the text
+      ambiguous     // more than one legal move fits the text
+   };
+
+   // Generates only the moves of pieces that fit the text, and tests only
+   // those for legality.
+   Status resolve (Board const& b, char const* begin, char const* end, Move& move);
+   Status resolve (Board const& b, char const* text, Move& move);
+   // legal must hold the legal moves of b
+   Status resolve (Board const& b, MoveList const& legal,
+                   char const* begin, char const* end, Move& move);
+
+   // Resolves count moves against one position, generating its legal moves
+   // once. Text i is [begins[i], ends[i]). Returns the number resolved.
+   unsigned resolve (Board const& b, char const* const* begins, char const* const* ends,
+                     unsigned count, Move* moves, Status* statuses);
+}
+
+
+#endif
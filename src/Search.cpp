@@ -0,0 +1,791 @@
+//==============================================================================
+// Search.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Search.h"
+#include "AnalysisCache.h"
+#include "Tablebase.h"
+#include "Trace.h"
+
+
+//==============================================================================
+// Tuning Constants
+//==============================================================================
+
+namespace {
+
+// null move pruning
+const int nullMoveMinDepth = 3;
+
+// late move reductions
+const int      lmrMinDepth     = 3;
+const unsigned lmrMinMoveIndex = 3;
+const unsigned lmrDeepIndex    = 8;
+const int      lmrGoodHistory  = 400;
+
+// futility pruning: margins by remaining depth
+const int futilityMaxDepth = 2;
+const int futilityMargin[futilityMaxDepth + 1] = { 0, 200, 450 };
+
+// reverse futility pruning: margin per ply of remaining depth
+const int reverseFutilityMaxDepth = 3;
+const int reverseFutilityMargin   = 120;
+
+const int historyMax = 1 << 14;
+
+// mate scores are stored relative to the node, not the root
+inline int scoreToTT (int score, unsigned ply) {
+   if (score >  Score::mateBound) return score + ply;
+   if (score < -Score::mateBound) return score - ply;
+   return score;
+}
+inline int scoreFromTT (int score, unsigned ply) {
+   if (score >  Score::mateBound) return score - ply;
+   if (score < -Score::mateBound) return score + ply;
+   return score;
+}
+
+//------------------------------------------------------------------------------
+// Whether a stored result is deep enough, and its bound tight enough, to stand
+// for this node's search.
+inline bool cutsOff (TTEntry const& entry, int depth, int alpha, int beta, unsigned ply, int& score) {
+   if (entry.depth < depth)
+      return false;
+   score = scoreFromTT(entry.score, ply);
+   return entry.bound == TTEntry::exact
+       || (entry.bound == TTEntry::lower && score >= beta)
+       || (entry.bound == TTEntry::upper && score <= alpha);
+}
+
+}
+
+
+//==============================================================================
+// TranspositionTable Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+void TranspositionTable::resize (unsigned megabytes) {
+   unsigned long long bytes = static_cast<unsigned long long>(megabytes) << 20;
+   unsigned long long count = 1;
+   while ((count << 1) * sizeof(Slot) <= bytes)
+      count <<= 1;
+   delete[] slots;
+   slots = new Slot[count];
+   mask = count - 1;
+   clear();
+}
+
+//------------------------------------------------------------------------------
+void TranspositionTable::clear () {
+   Trace::Scope scope("search", "clear table", (mask + 1) * sizeof(Slot));
+   for (unsigned long long i=0; i<=mask; ++i) {
+      slots[i].check.store(0, std::memory_order_relaxed);
+      slots[i].data.store(0, std::memory_order_relaxed);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Data word layout: score in bits 0-15, move in 16-31, depth in 32-39, bound in 40-47.
+bool TranspositionTable::probe (HashKey key, TTEntry& entry) const {
+   COUNT(hashProbes);
+   Slot const& slot = slots[key & mask];
+   unsigned long long data  = slot.data.load(std::memory_order_relaxed);
+   unsigned long long check = slot.check.load(std::memory_order_relaxed);
+   if ((check ^ data) != key)
+      return false;
+   COUNT(hashHits);
+   entry.score = static_cast<short>(data & 0xffff);
+   entry.move  = static_cast<unsigned short>((data >> 16) & 0xffff);
+   entry.depth = static_cast<unsigned char>((data >> 32) & 0xff);
+   entry.bound = static_cast<unsigned char>((data >> 40) & 0xff);
+   return entry.bound != 0;
+}
+
+//------------------------------------------------------------------------------
+void TranspositionTable::store (HashKey key, int score, Move const& move, int depth, unsigned char bound) {
+   Slot& slot = slots[key & mask];
+   unsigned short packedMove = move.pack();
+   // keep the old move if we have nothing better for the same position
+   if (!move.valid()) {
+      TTEntry old;
+      if (probe(key, old))
+         packedMove = old.move;
+   }
+   unsigned long long data = static_cast<unsigned short>(static_cast<short>(score))
+                           | (static_cast<unsigned long long>(packedMove) << 16)
+                           | (static_cast<unsigned long long>(depth < 0 ? 0 : depth) << 32)
+                           | (static_cast<unsigned long long>(bound) << 40);
+   slot.data.store(data, std::memory_order_relaxed);
+   slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+
+//==============================================================================
+// SearchLimits Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+long long SearchLimits::allotted (bool light) const {
+   if (moveTime)
+      return moveTime;
+
+   long long time = light ? lightTime : darkTime;
+   long long increment = light ? lightIncrement : darkIncrement;
+   if (time <= 0)
+      return 0;
+
+   // leave a little for communication overhead, and never risk more than half the clock
+   unsigned togo = movesToGo ? movesToGo : 30;
+   long long t = time / togo + increment * 3 / 4;
+   if (t > time / 2)
+      t = time / 2;
+   if (t > time - 50)
+      t = time - 50;
+   return t < 1 ? 1 : t;
+}
+
+
+//==============================================================================
+// Searcher Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+Searcher::Searcher ():
+   _tt(&_ownTT),
+   _signals(&_ownSignals),
+   _observer(0),
+   _tablebases(0),
+   _cache(0),
+   _nodes(0),
+   _nodeLimit(0)
+{
+   clear();
+}
+
+//------------------------------------------------------------------------------
+void Searcher::setSharedTable (TranspositionTable* tt) {
+   if (tt) {
+      _ownTT.resize(0);
+      _tt = tt;
+   } else {
+      if (_tt != &_ownTT)
+         _ownTT.resize(16);
+      _tt = &_ownTT;
+   }
+}
+
+//------------------------------------------------------------------------------
+void Searcher::clear () {
+   _tt->clear();
+   memset(_history, 0, sizeof(_history));
+   for (unsigned i=0; i<maxPly; ++i)
+      _killers[i][0] = _killers[i][1] = Move();
+   memset(_depthNodes, 0, sizeof(_depthNodes));
+   _nodes = 0;
+   _completedDepth = 0;
+   _bestMove = Move();
+   _score = 0;
+}
+
+//------------------------------------------------------------------------------
+Move Searcher::search (Board const& root, unsigned depth) {
+   SearchLimits limits;
+   limits.depth = depth;
+   return search(root, limits);
+}
+
+//------------------------------------------------------------------------------
+Move Searcher::search (Board const& root, SearchLimits const& limits, unsigned firstDepth) {
+   long long start = millisecondsNow();
+   _nodes = 0;
+   _nodeLimit = limits.nodes;
+   _completedDepth = 0;
+   _bestMove = Move();
+   _score = 0;
+   memset(_depthNodes, 0, sizeof(_depthNodes));
+
+   // when searching alone we manage our own clock
+   if (_signals == &_ownSignals) {
+      long long allotted = limits.infinite ? 0 : limits.allotted(root.pathDependence().lightMove());
+      _ownSignals.stop = false;
+      _ownSignals.pondering = limits.ponder;
+      _ownSignals.deadline = allotted ? start + allotted : 0;
+   }
+
+   unsigned maxDepth = maxPly - 1;
+   if (limits.depth && limits.depth < maxDepth)
+      maxDepth = limits.depth;
+
+   for (unsigned d = firstDepth; d <= maxDepth; ++d) {
+      Trace::Scope scope("search", "iteration", d);
+      unsigned long long before = nodes();
+      int score = searchRoot(root, d, -Score::infinity, Score::infinity);
+      if (stopped())
+         break;
+      _score = score;
+      _depthNodes[d] = nodes() - before;
+      _completedDepth = d;
+      if (_observer)
+         _observer->iterationDone(*this, root, d, score, millisecondsNow() - start);
+   }
+
+   // stopped before a single move was searched: any legal move will do
+   if (!_bestMove.valid()) {
+      MoveList list;
+      generateLegalMoves(root, list);
+      if (list.size > 0)
+         _bestMove = list[0];
+   }
+   return _bestMove;
+}
+
+//------------------------------------------------------------------------------
+unsigned Searcher::principalVariation (Board const& root, Move* pv, unsigned max) const {
+   Board boards[2];
+   boards[0] = root;
+   unsigned n = 0;
+   MoveList list;
+   TTEntry entry;
+   while (n < max && _tt->probe(positionKey(boards[n & 1]), entry)) {
+      Move m = Move::unpack(entry.move);
+      if (!m.valid())
+         break;
+      // the table may hold a move from a colliding position, so check it's legal
+      generateLegalMoves(boards[n & 1], list);
+      unsigned i = 0;
+      while (i < list.size && list[i] != m)
+         ++i;
+      if (i == list.size)
+         break;
+      boards[n & 1].realize(m, boards[(n + 1) & 1]);
+      pv[n++] = m;
+   }
+   return n;
+}
+
+//------------------------------------------------------------------------------
+// Checks the stop flag at every node, and the clock every 1024 nodes.
+bool Searcher::stopped () {
+   if (_signals->stop.load(std::memory_order_relaxed))
+      return true;
+   unsigned long long n = nodes();
+   if (_nodeLimit && n >= _nodeLimit) {
+      _signals->stop = true;
+      return true;
+   }
+   if ((n & 1023) == 0) {
+      long long deadline = _signals->deadline.load(std::memory_order_relaxed);
+      if (deadline && !_signals->pondering.load(std::memory_order_relaxed)
+          && millisecondsNow() >= deadline) {
+         _signals->stop = true;
+         return true;
+      }
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+int Searcher::searchRoot (Board const& b, int depth, int alpha, int beta) {
+   HashKey key = positionKey(b);
+   TTEntry entry;
+   Move ttMove = _tt->probe(key, entry) ? Move::unpack(entry.move) : Move();
+   // prefer the best move of the previous iteration, even if its slot was overwritten
+   if (_bestMove.valid())
+      ttMove = _bestMove;
+
+   MoveList list;
+   int scores[MoveList::capacity];
+   generatePseudoLegalMoves(b, list);
+   scoreMoves(b, list, scores, ttMove, 0);
+
+   bool light = b.pathDependence().lightMove();
+   bool inCheck = _arbiter.isInCheck(b.bitboard(), light);
+   Board child;
+   Move best;
+   unsigned legal = 0;
+   countNode(0);
+
+   for (unsigned i=0; i<list.size; ++i) {
+      pickMove(list, scores, i);
+      Move const& m = list[i];
+      b.realize(m, child);
+      if (_arbiter.isInCheck(child.bitboard(), light))
+         continue;
+      ++legal;
+
+      bool givesCheck = _arbiter.isInCheck(child.bitboard(), !light);
+      int newDepth = depth - 1 + ((_options.checkExtensions && givesCheck) ? 1 : 0);
+      int score;
+      if (legal == 1) {
+         score = -alphaBeta(child, newDepth, -beta, -alpha, 1, true);
+      } else {
+         score = -alphaBeta(child, newDepth, -alpha - 1, -alpha, 1, true);
+         if (score > alpha && score < beta && !stopped())
+            score = -alphaBeta(child, newDepth, -beta, -alpha, 1, true);
+      }
+      // a score from an interrupted search means nothing
+      if (stopped())
+         break;
+
+      if (score > alpha) {
+         alpha = score;
+         best = m;
+         if (score >= beta)
+            break;
+      }
+   }
+
+   if (legal == 0)
+      return inCheck ? Score::matedIn(0) : 0;
+
+   // moves that finished before a stop are still trustworthy
+   if (best.valid()) {
+      _bestMove = best;
+      if (!stopped()) {
+         _tt->store(key, scoreToTT(alpha, 0), best, depth, TTEntry::exact);
+         if (_cache)
+            _cache->store(key, scoreToTT(alpha, 0), best, depth, TTEntry::exact);
+      }
+   }
+   return alpha;
+}
+
+//------------------------------------------------------------------------------
+int Searcher::alphaBeta (Board const& b, int depth, int alpha, int beta, unsigned ply, bool nullAllowed) {
+   if (depth <= 0 || ply >= maxPly - 1)
+      return quiesce(b, alpha, beta, ply);
+
+   countNode(ply);
+   if (stopped())
+      return 0;
+   bool pvNode = beta - alpha > 1;
+   int originalAlpha = alpha;
+
+   // endgame tables: exact, so they come before the transposition table
+   unsigned result, distance;
+   if (_tablebases && _tablebases->probe(b, result, distance)) {
+      if (result == TB::win)
+         return Score::mateIn(ply + distance);
+      if (result == TB::loss)
+         return Score::matedIn(ply + distance);
+      return 0;
+   }
+
+   // persistent cache, then transposition table
+   HashKey key = positionKey(b);
+   TTEntry entry;
+   Move ttMove;
+   int ttScore;
+   bool useCache = _cache && depth >= _cache->minDepth();
+   if (useCache && _cache->probe(key, entry)) {
+      ttMove = Move::unpack(entry.move);
+      // an exact result from an earlier session may end even a PV node, which
+      // is what makes repeated analysis cheap
+      if ((!pvNode || entry.bound == TTEntry::exact)
+          && cutsOff(entry, depth, alpha, beta, ply, ttScore)) {
+         COUNT(hashCutoffs);
+         return ttScore;
+      }
+   }
+   if (_tt->probe(key, entry)) {
+      ttMove = Move::unpack(entry.move);
+      if (!pvNode && cutsOff(entry, depth, alpha, beta, ply, ttScore)) {
+         COUNT(hashCutoffs);
+         return ttScore;
+      }
+   }
+
+   bool light = b.pathDependence().lightMove();
+   bool inCheck = _arbiter.isInCheck(b.bitboard(), light);
+   int staticEval = inCheck ? -Score::infinity : _eval.evaluate(b);
+
+   // reverse futility pruning: far enough above beta that a quiet position won't fall back
+   if (_options.reverseFutility && !pvNode && !inCheck && depth <= reverseFutilityMaxDepth
+       && !Score::isMate(beta) && staticEval - reverseFutilityMargin * depth >= beta)
+      return staticEval;
+
+   // null move pruning: if passing still fails high, a real move surely would
+   if (_options.nullMove && nullAllowed && !pvNode && !inCheck && depth >= nullMoveMinDepth
+       && staticEval >= beta && hasNonPawnMaterial(b)) {
+      int reduction = 2 + depth / 6;
+      Board passed;
+      b.realizeNull(passed);
+      int score = -alphaBeta(passed, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+      if (stopped())
+         return 0;
+      if (score >= beta)
+         return Score::isMate(score) ? beta : score;
+   }
+
+   MoveList list;
+   int scores[MoveList::capacity];
+   generatePseudoLegalMoves(b, list);
+   scoreMoves(b, list, scores, ttMove, ply);
+
+   bool canFutilityPrune = _options.futility && !pvNode && !inCheck && depth <= futilityMaxDepth
+                        && !Score::isMate(alpha)
+                        && staticEval + futilityMargin[depth] <= alpha;
+
+   Board child;
+   Move best;
+   int bestScore = -Score::infinity;
+   unsigned legal = 0;
+
+   for (unsigned i=0; i<list.size; ++i) {
+      pickMove(list, scores, i);
+      Move const& m = list[i];
+      b.realize(m, child);
+      if (_arbiter.isInCheck(child.bitboard(), light))
+         continue;
+      ++legal;
+
+      bool quiet = isQuiet(b, m);
+      bool givesCheck = _arbiter.isInCheck(child.bitboard(), !light);
+
+      // futility pruning: quiet moves can't bring a hopeless node back above alpha
+      if (canFutilityPrune && legal > 1 && quiet && !givesCheck) {
+         if (staticEval + futilityMargin[depth] > bestScore)
+            bestScore = staticEval + futilityMargin[depth];
+         continue;
+      }
+
+      int newDepth = depth - 1 + ((_options.checkExtensions && givesCheck) ? 1 : 0);
+      int score;
+      if (legal == 1) {
+         score = -alphaBeta(child, newDepth, -beta, -alpha, ply + 1, true);
+      } else {
+         // late move reductions: quiet moves ordered late are probably bad
+         int reduction = 0;
+         if (_options.lateMoveReductions && depth >= lmrMinDepth && legal > lmrMinMoveIndex
+             && quiet && !inCheck && !givesCheck
+             && m != _killers[ply][0] && m != _killers[ply][1]) {
+            reduction = 1;
+            if (legal > lmrDeepIndex)
+               ++reduction;
+            if (_history[b.bitboard().get(m.src)][m.dst] > lmrGoodHistory)
+               --reduction;
+            if (reduction > newDepth - 1)
+               reduction = newDepth - 1;
+            if (reduction < 0)
+               reduction = 0;
+         }
+
+         score = -alphaBeta(child, newDepth - reduction, -alpha - 1, -alpha, ply + 1, true);
+         if (score > alpha && reduction > 0 && !stopped())
+            score = -alphaBeta(child, newDepth, -alpha - 1, -alpha, ply + 1, true);
+         if (score > alpha && score < beta && !stopped())
+            score = -alphaBeta(child, newDepth, -beta, -alpha, ply + 1, true);
+      }
+      if (stopped())
+         return 0;
+
+      if (score > bestScore) {
+         bestScore = score;
+         if (score > alpha) {
+            alpha = score;
+            best = m;
+            if (score >= beta) {
+               COUNT(betaCutoffs);
+               if (quiet)
+                  rewardQuiet(b, m, depth, ply);
+               break;
+            }
+         }
+      }
+   }
+
+   if (legal == 0)
+      return inCheck ? Score::matedIn(ply) : 0;
+
+   unsigned char bound = bestScore >= beta ? TTEntry::lower
+                       : (bestScore > originalAlpha ? TTEntry::exact : TTEntry::upper);
+   _tt->store(key, scoreToTT(bestScore, ply), best, depth, bound);
+   if (useCache)
+      _cache->store(key, scoreToTT(bestScore, ply), best, depth, bound);
+   return bestScore;
+}
+
+//------------------------------------------------------------------------------
+int Searcher::quiesce (Board const& b, int alpha, int beta, unsigned ply) {
+   countNode(ply);
+   if (stopped())
+      return 0;
+   bool light = b.pathDependence().lightMove();
+   int standPat = _eval.evaluate(b);
+   if (standPat >= beta || ply >= maxPly - 1)
+      return standPat;
+   if (standPat > alpha)
+      alpha = standPat;
+
+   MoveList list;
+   int scores[MoveList::capacity];
+   generateCaptures(b, list);
+   scoreMoves(b, list, scores, Move(), ply);
+
+   Board child;
+   for (unsigned i=0; i<list.size; ++i) {
+      pickMove(list, scores, i);
+      b.realize(list[i], child);
+      if (_arbiter.isInCheck(child.bitboard(), light))
+         continue;
+      int score = -quiesce(child, -beta, -alpha, ply + 1);
+      if (stopped())
+         return 0;
+      if (score > alpha) {
+         alpha = score;
+         if (score >= beta) {
+            COUNT(betaCutoffs);
+            break;
+         }
+      }
+   }
+   return alpha;
+}
+
+//------------------------------------------------------------------------------
+// Order: hash move, captures by most valuable victim / least valuable attacker,
+// killers, then quiet moves by history.
+void Searcher::scoreMoves (Board const& b, MoveList const& list, int* scores, Move const& ttMove, unsigned ply) {
+   BitBoard const& bb = b.bitboard();
+   for (unsigned i=0; i<list.size; ++i) {
+      Move const& m = list[i];
+      if (m == ttMove) {
+         scores[i] = 1 << 30;
+      } else if (m.isEnPassant()) {
+         scores[i] = (1 << 20) + 100 * 16;
+      } else if (m.isBasic() && isPiece(bb.get(m.dst))) {
+         scores[i] = (1 << 20) + Evaluator::pieceValue(bb.get(m.dst)) * 16
+                   - Evaluator::pieceValue(bb.get(m.src)) / 16;
+      } else if (m.kind == Move::promoteQueen) {
+         // ranked with the captures, by what the pawn becomes (and takes)
+         Piece taken = bb.get(m.dst);
+         scores[i] = (1 << 20) + (isPiece(taken) ? Evaluator::pieceValue(taken) * 16 : 0)
+                   + Evaluator::pieceValue(m.promotion(b.pathDependence().lightMove()));
+      } else if (m == _killers[ply][0]) {
+         scores[i] = (1 << 19) + 1;
+      } else if (m == _killers[ply][1]) {
+         scores[i] = 1 << 19;
+      } else if (m.isBasic()) {
+         scores[i] = _history[bb.get(m.src)][m.dst];
+      } else {
+         scores[i] = 0;
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+// Selection sort step: moves the best remaining move into slot i.
+void Searcher::pickMove (MoveList& list, int* scores, unsigned i) {
+   unsigned best = i;
+   for (unsigned j=i+1; j<list.size; ++j) {
+      if (scores[j] > scores[best])
+         best = j;
+   }
+   if (best != i) {
+      Move m = list[i];
+      list[i] = list[best];
+      list[best] = m;
+      int s = scores[i];
+      scores[i] = scores[best];
+      scores[best] = s;
+   }
+}
+
+//------------------------------------------------------------------------------
+bool Searcher::isQuiet (Board const& b, Move const& m) const {
+   // under-promotions that don't capture are treated as quiet
+   if (m.isEnPassant() || m.kind == Move::promoteQueen)
+      return false;
+   return !(m.isSimple() && isPiece(b.bitboard().get(m.dst)));
+}
+
+//------------------------------------------------------------------------------
+bool Searcher::hasNonPawnMaterial (Board const& b) const {
+   bool light = b.pathDependence().lightMove();
+   PieceItr itr(b.bitboard(), light ? PieceItr::light_pieces : PieceItr::dark_pieces);
+   for ( ; itr.valid(); ++itr) {
+      if (!isPawn(itr.piece()) && !isKing(itr.piece()))
+         return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+void Searcher::rewardQuiet (Board const& b, Move const& m, int depth, unsigned ply) {
+   if (m != _killers[ply][0]) {
+      _killers[ply][1] = _killers[ply][0];
+      _killers[ply][0] = m;
+   }
+   if (!m.isBasic())
+      return;
+   int& h = _history[b.bitboard().get(m.src)][m.dst];
+   h += depth * depth;
+   // age the whole table rather than let one entry saturate
+   if (h > historyMax) {
+      for (unsigned p=0; p<16; ++p)
+         for (unsigned s=0; s<64; ++s)
+            _history[p][s] /= 2;
+   }
+}
+
+
+//==============================================================================
+// SearchPool Methods
+//==============================================================================
+
+//------------------------------------------------------------------------------
+SearchPool::SearchPool (): _generation(0), _running(0), _quit(false), _allotted(0) {
+   _searchers.push_back(new Searcher());
+   _searchers[0]->setSharedTable(&_tt);
+   _searchers[0]->setSignals(&_signals);
+}
+
+//------------------------------------------------------------------------------
+SearchPool::~SearchPool () {
+   stopHelpers();
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      delete _searchers[i];
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::setThreads (unsigned count) {
+   if (count < 1)
+      count = 1;
+   stopHelpers();
+
+   while (_searchers.size() > count) {
+      delete _searchers.back();
+      _searchers.pop_back();
+   }
+   while (_searchers.size() < count) {
+      Searcher* s = new Searcher();
+      s->setSharedTable(&_tt);
+      s->setSignals(&_signals);
+      s->setOptions(_searchers[0]->options());
+      s->setTablebases(_searchers[0]->tablebases());
+      s->setAnalysisCache(_searchers[0]->analysisCache());
+      _searchers.push_back(s);
+   }
+
+   for (unsigned i=1; i<count; ++i)
+      _helpers.push_back(std::thread(&SearchPool::helperLoop, this, i, _generation));
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::setOptions (SearchOptions const& options) {
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      _searchers[i]->setOptions(options);
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::setTablebases (Tablebases const* tablebases) {
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      _searchers[i]->setTablebases(tablebases);
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::setAnalysisCache (AnalysisCache* cache) {
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      _searchers[i]->setAnalysisCache(cache);
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::clear () {
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      _searchers[i]->clear();
+}
+
+//------------------------------------------------------------------------------
+unsigned long long SearchPool::nodes () const {
+   unsigned long long total = 0;
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      total += _searchers[i]->nodes();
+   return total;
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::prepare (Board const& root, SearchLimits const& limits) {
+   long long start = millisecondsNow();
+   _allotted = limits.infinite ? 0 : limits.allotted(root.pathDependence().lightMove());
+   _signals.stop = false;
+   _signals.pondering = limits.ponder;
+   _signals.deadline = _allotted ? start + _allotted : 0;
+}
+
+//------------------------------------------------------------------------------
+Move SearchPool::search (Board const& root, SearchLimits const& limits, bool prepared) {
+   Trace::Scope scope("search", "search", _searchers.size());
+   if (!prepared)
+      prepare(root, limits);
+
+   for (unsigned i=0; i<_searchers.size(); ++i)
+      _searchers[i]->resetNodes();
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _root = root;
+      _limits = limits;
+      _running = _helpers.size();
+      ++_generation;
+   }
+   _wake.notify_all();
+
+   Move best = _searchers[0]->search(root, limits);
+
+   // helpers never finish on their own before the main thread does
+   _signals.stop = true;
+   Trace::Scope waiting("search", "wait for helpers");
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (_running > 0)
+      _idle.wait(lock);
+   return best;
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::ponderhit () {
+   if (!_signals.pondering)
+      return;
+   _signals.deadline = _allotted ? millisecondsNow() + _allotted : 0;
+   _signals.pondering = false;
+}
+
+//------------------------------------------------------------------------------
+void SearchPool::stopHelpers () {
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _quit = true;
+   }
+   _wake.notify_all();
+   for (unsigned i=0; i<_helpers.size(); ++i)
+      _helpers[i].join();
+   _helpers.clear();
+   _quit = false;
+}
+
+//------------------------------------------------------------------------------
+// Helpers on odd threads start one ply deeper, so the threads spread out.
+void SearchPool::helperLoop (unsigned index, unsigned generation) {
+   Trace::nameThread("search helper");
+   std::unique_lock<std::mutex> lock(_mutex);
+   while (true) {
+      while (!_quit && _generation == generation)
+         _wake.wait(lock);
+      if (_quit)
+         return;
+      generation = _generation;
+      Board root = _root;
+      SearchLimits limits = _limits;
+      lock.unlock();
+
+      Trace::instant("search", "helper woke", index);
+      {
+         Trace::Scope scope("search", "helper search", index);
+         _searchers[index]->search(root, limits, 1 + (index & 1));
+      }
+
+      lock.lock();
+      if (--_running == 0)
+         _idle.notify_all();
+   }
+}
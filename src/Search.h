@@ -0,0 +1,324 @@
+//==============================================================================
+// Search.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef SEARCH
+#define SEARCH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Chess.h"
+#include "Evaluation.h"
+
+class Tablebases;
+class AnalysisCache;
+
+
+//==============================================================================
+// Hash Keys
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// 64 bit position key built from two BitBoard hashes. Since the path dependent
+// state is written into the board's empty squares, this identifies positions
+// (not just piece placements).
+inline HashKey positionKey (Board const& b) {
+   return (static_cast<HashKey>(b.bitboard().hash()) << 32)
+        | b.bitboard().hash(0x5eed1e55u);
+}
+
+//------------------------------------------------------------------------------
+// Milliseconds on a monotonic clock, for time controls.
+inline long long millisecondsNow () {
+   return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+   ).count();
+}
+
+
+//==============================================================================
+// Transposition Table
+//==============================================================================
+
+//------------------------------------------------------------------------------
+struct TTEntry {
+   short          score;
+   unsigned short move;
+   unsigned char  depth;
+   unsigned char  bound;
+
+   static const unsigned char upper = 1;   // score is at most this
+   static const unsigned char lower = 2;   // score is at least this
+   static const unsigned char exact = 3;
+};
+
+//------------------------------------------------------------------------------
+// A single slot, always replace table, shared by all search threads.
+/*
+ * Each slot stores its data word and the key xored with that data word, so a
+ * slot torn by two threads writing at once simply fails to match on probe.
+ * The size is rounded down to a power of two.
+ */
+class TranspositionTable {
+private:
+   struct Slot {
+      std::atomic<unsigned long long> check;
+      std::atomic<unsigned long long> data;
+   };
+   Slot* slots;
+   unsigned long long mask;
+
+   TranspositionTable (TranspositionTable const&);
+   void operator= (TranspositionTable const&);
+
+public:
+   TranspositionTable (): slots(0), mask(0) { resize(16); }
+   ~TranspositionTable () { delete[] slots; }
+   void resize (unsigned megabytes);
+   void clear ();
+
+   bool probe (HashKey key, TTEntry& entry) const;
+   void store (HashKey key, int score, Move const& move, int depth, unsigned char bound);
+};
+
+
+//==============================================================================
+// Search Options and Limits
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Each selectivity feature can be switched off on its own, so its effect on
+// the number of nodes needed to reach a given depth can be measured.
+struct SearchOptions {
+   bool nullMove;
+   bool lateMoveReductions;
+   bool futility;
+   bool reverseFutility;
+   bool checkExtensions;
+
+   SearchOptions ():
+      nullMove(true),
+      lateMoveReductions(true),
+      futility(true),
+      reverseFutility(true),
+      checkExtensions(true)
+   {}
+};
+
+//------------------------------------------------------------------------------
+// When to stop searching. Zero means "no limit" for every field.
+struct SearchLimits {
+   unsigned depth;
+   unsigned long long nodes;
+   // all times in milliseconds
+   long long moveTime;
+   long long lightTime;
+   long long darkTime;
+   long long lightIncrement;
+   long long darkIncrement;
+   unsigned movesToGo;
+   // search until told to stop
+   bool infinite;
+   // search the predicted position until ponderhit or stop
+   bool ponder;
+
+   SearchLimits ():
+      depth(0), nodes(0), moveTime(0), lightTime(0), darkTime(0),
+      lightIncrement(0), darkIncrement(0), movesToGo(0), infinite(false), ponder(false)
+   {}
+
+   // milliseconds to spend on a move by the given side, or 0 for no time limit
+   long long allotted (bool light) const;
+};
+
+//------------------------------------------------------------------------------
+// Flags shared between the searching threads and whoever controls them.
+struct SearchSignals {
+   std::atomic<bool> stop;
+   std::atomic<bool> pondering;
+   // steady clock time in milliseconds at which to stop, or 0 for none
+   std::atomic<long long> deadline;
+
+   SearchSignals (): stop(false), pondering(false), deadline(0) {}
+};
+
+
+//==============================================================================
+// Search Observer
+//==============================================================================
+
+class Searcher;
+
+//------------------------------------------------------------------------------
+// Receives progress from the main search thread (ex, to print UCI info lines).
+class SearchObserver {
+public:
+   virtual ~SearchObserver () {}
+   virtual void iterationDone (Searcher const& searcher, Board const& root,
+                               unsigned depth, int score, long long elapsed) = 0;
+};
+
+
+//==============================================================================
+// Searcher
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Iterative deepening principal variation search with quiescence.
+/*
+ * A Searcher is used by one thread at a time. Several Searchers may share a
+ * TranspositionTable and SearchSignals (see SearchPool); by default each uses
+ * its own.
+ */
+class Searcher {
+public:
+   static const unsigned maxPly = 64;
+
+private:
+   SearchOptions _options;
+   TranspositionTable _ownTT;
+   SearchSignals _ownSignals;
+   TranspositionTable* _tt;
+   SearchSignals* _signals;
+   SearchObserver* _observer;
+   Evaluator _eval;
+   PathIndependentArbiter _arbiter;
+   Tablebases const* _tablebases;
+   AnalysisCache* _cache;
+
+   // history[piece][dst] rewards quiet moves that caused cutoffs
+   int _history[16][64];
+   Move _killers[maxPly][2];
+
+   std::atomic<unsigned long long> _nodes;
+   unsigned long long _nodeLimit;
+   // nodes spent on each iteration of the last search
+   unsigned long long _depthNodes[maxPly];
+   unsigned _completedDepth;
+   Move _bestMove;
+   int _score;
+
+public:
+   Searcher ();
+   void setOptions (SearchOptions const& options) { _options = options; }
+   SearchOptions const& options () const { return _options; }
+   // a shared table replaces (and frees) the searcher's own table
+   void setSharedTable (TranspositionTable* tt);
+   void setSignals (SearchSignals* signals) { _signals = signals ? signals : &_ownSignals; }
+   void setObserver (SearchObserver* observer) { _observer = observer; }
+   // positions the tables cover are scored from them below the root
+   void setTablebases (Tablebases const* tablebases) { _tablebases = tablebases; }
+   Tablebases const* tablebases () const { return _tablebases; }
+   // a persistent cache is probed before the transposition table and gets
+   // the results deep enough for it
+   void setAnalysisCache (AnalysisCache* cache) { _cache = cache; }
+   AnalysisCache* analysisCache () const { return _cache; }
+   TranspositionTable& tt () { return *_tt; }
+   SearchSignals& signals () { return *_signals; }
+   Evaluator& evaluator () { return _eval; }
+   // forgets everything learned in previous searches
+   void clear ();
+
+   // searches root to the given depth and returns the best move found
+   Move search (Board const& root, unsigned depth);
+   // searches root until a limit is reached or the signals say stop
+   Move search (Board const& root, SearchLimits const& limits, unsigned firstDepth = 1);
+
+   Move bestMove () const { return _bestMove; }
+   int  score    () const { return _score; }
+   unsigned long long nodes () const { return _nodes.load(std::memory_order_relaxed); }
+   void resetNodes () { _nodes = 0; }
+   unsigned completedDepth () const { return _completedDepth; }
+   unsigned long long nodesAtDepth (unsigned d) const { return d < maxPly ? _depthNodes[d] : 0; }
+   // follows hash moves from root; returns the number of moves written
+   unsigned principalVariation (Board const& root, Move* pv, unsigned max) const;
+
+private:
+   void countNode (unsigned ply) {
+      _nodes.store(_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      COUNT(nodes);
+      COUNT_PLY(ply);
+   }
+   bool stopped ();
+   int searchRoot (Board const& b, int depth, int alpha, int beta);
+   int alphaBeta (Board const& b, int depth, int alpha, int beta, unsigned ply, bool nullAllowed);
+   int quiesce (Board const& b, int alpha, int beta, unsigned ply);
+
+   void scoreMoves (Board const& b, MoveList const& list, int* scores, Move const& ttMove, unsigned ply);
+   static void pickMove (MoveList& list, int* scores, unsigned i);
+   bool isQuiet (Board const& b, Move const& m) const;
+   bool hasNonPawnMaterial (Board const& b) const;
+   void rewardQuiet (Board const& b, Move const& m, int depth, unsigned ply);
+};
+
+
+//==============================================================================
+// Search Pool
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Runs one search on several threads sharing a transposition table (lazy SMP).
+/*
+ * Thread 0 is the caller of search(); it alone reports to the observer and
+ * decides the move. Helper threads sleep between searches and only feed the
+ * shared table.
+ */
+class SearchPool {
+private:
+   TranspositionTable _tt;
+   SearchSignals _signals;
+   std::vector<Searcher*> _searchers;
+   std::vector<std::thread> _helpers;
+
+   std::mutex _mutex;
+   std::condition_variable _wake;
+   std::condition_variable _idle;
+   unsigned _generation;
+   unsigned _running;
+   bool _quit;
+   Board _root;
+   SearchLimits _limits;
+   std::atomic<long long> _allotted;
+
+   SearchPool (SearchPool const&);
+   void operator= (SearchPool const&);
+
+public:
+   SearchPool ();
+   ~SearchPool ();
+
+   // only call these while no search is running
+   void setThreads (unsigned count);
+   void setHashSize (unsigned megabytes) { _tt.resize(megabytes); }
+   void setOptions (SearchOptions const& options);
+   void setObserver (SearchObserver* observer) { _searchers[0]->setObserver(observer); }
+   void setTablebases (Tablebases const* tablebases);
+   void setAnalysisCache (AnalysisCache* cache);
+   void clear ();
+
+   unsigned threads () const { return _searchers.size(); }
+   SearchSignals& signals () { return _signals; }
+   Searcher& mainSearcher () { return *_searchers[0]; }
+   unsigned long long nodes () const;
+
+   // resets the signals for a search of root under limits; a stop or
+   // ponderhit from then on reaches the search even before it has started
+   void prepare (Board const& root, SearchLimits const& limits);
+   // searches on all threads; returns when the main thread is done. Calls
+   // prepare first unless the caller already has.
+   Move search (Board const& root, SearchLimits const& limits, bool prepared = false);
+   void stop () { _signals.stop = true; }
+   // the predicted move was played: the clock starts now (once per search)
+   void ponderhit ();
+
+private:
+   void stopHelpers ();
+   void helperLoop (unsigned index, unsigned generation);
+};
+
+#endif
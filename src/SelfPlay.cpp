@@ -0,0 +1,311 @@
+//==============================================================================
+// SelfPlay.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "SelfPlay.h"
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include "Trace.h"
+
+
+//==============================================================================
+// Sequential Probability Ratio Test
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// The expected score of a player elo points stronger than its opponent.
+double expectedScore (double elo) {
+   return 1 / (1 + std::pow(10.0, -elo / 400));
+}
+
+//------------------------------------------------------------------------------
+double eloOf (double score) {
+   if (score <= 0) score = 1e-6;
+   if (score >= 1) score = 1 - 1e-6;
+   return -400 * std::log10(1 / score - 1);
+}
+
+}
+
+//------------------------------------------------------------------------------
+Sprt::Sprt (double elo0, double elo1, double alpha, double beta):
+   _elo0(elo0), _elo1(elo1), _alpha(alpha), _beta(beta), _wins(0), _draws(0), _losses(0)
+{}
+
+//------------------------------------------------------------------------------
+void Sprt::add (int result) {
+   if (result > 0)
+      ++_wins;
+   else if (result < 0)
+      ++_losses;
+   else
+      ++_draws;
+}
+
+//------------------------------------------------------------------------------
+// The mean score per game and its variance.
+void Sprt::moments (double& score, double& variance) const {
+   double n = games();
+   score = (_wins + 0.5 * _draws) / n;
+   variance = (_wins * (1 - score) * (1 - score) + _draws * (0.5 - score) * (0.5 - score)
+               + _losses * score * score) / n;
+}
+
+//------------------------------------------------------------------------------
+double Sprt::llr () const {
+   double n = games();
+   if (n == 0)
+      return 0;
+   double s, variance;
+   moments(s, variance);
+   if (variance <= 0)
+      return 0;
+   double s0 = expectedScore(_elo0);
+   double s1 = expectedScore(_elo1);
+   return n * (s1 - s0) * (2 * s - s0 - s1) / (2 * variance);
+}
+
+//------------------------------------------------------------------------------
+double Sprt::lowerBound () const {
+   return std::log(_beta / (1 - _alpha));
+}
+
+//------------------------------------------------------------------------------
+double Sprt::upperBound () const {
+   return std::log((1 - _beta) / _alpha);
+}
+
+//------------------------------------------------------------------------------
+int Sprt::decision () const {
+   double l = llr();
+   if (l >= upperBound())
+      return 1;
+   if (l <= lowerBound())
+      return -1;
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+double Sprt::elo () const {
+   return games() ? eloOf((_wins + 0.5 * _draws) / games()) : 0;
+}
+
+//------------------------------------------------------------------------------
+double Sprt::eloMargin () const {
+   double n = games();
+   if (n == 0)
+      return 0;
+   double s, variance;
+   moments(s, variance);
+   double error = 1.96 * std::sqrt(variance / n);
+   return (eloOf(s + error) - eloOf(s - error)) / 2;
+}
+
+
+//==============================================================================
+// Self Play
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// Whether the current position has occurred twice before with the same side
+// to move, looking back no further than the last capture or pawn move.
+bool isThreefold (Game const& game) {
+   Board const& b = game.currentBoard();
+   HashKey key = positionKey(b);
+   unsigned back = b.pathDependence().halfmoveClock();
+   unsigned seen = 1;
+   for (unsigned d = 2; d <= back && d <= game.plies(); d += 2) {
+      if (positionKey(game.board(game.plies() - d)) == key && ++seen == 3)
+         return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// Bare kings, or a lone knight or bishop against a bare king.
+bool isInsufficientMaterial (Board const& b) {
+   unsigned minors = 0;
+   for (Square s = 0; s < 64; ++s) {
+      Piece p = b.bitboard().get(s);
+      if (!isPiece(p) || isKing(p))
+         continue;
+      if (!isKnight(p) && p != PC::b0 && p != PC::b1)
+         return false;
+      if (++minors > 1)
+         return false;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Plays up to plies random legal moves, the same ones for the same seed,
+// never one that leaves the other side without a move.
+void playRandomPlies (Game& game, unsigned plies, unsigned long long seed) {
+   unsigned long long state = seed * 0x9e3779b97f4a7c15ull + 0x5e1f9a7ull;
+   for (unsigned i=0; i<plies; ++i) {
+      MoveList list;
+      generateLegalMoves(game.currentBoard(), list);
+      MoveList playable;
+      for (unsigned j=0; j<list.size; ++j) {
+         Board child;
+         game.currentBoard().realize(list[j], child);
+         if (hasLegalMove(child))
+            playable.push(list[j]);
+      }
+      if (playable.size == 0)
+         return;
+      // splitmix64
+      unsigned long long z = (state += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      z ^= z >> 31;
+      game.move(playable[z % playable.size]);
+   }
+}
+
+}
+
+//------------------------------------------------------------------------------
+SelfPlay::SelfPlay (SelfPlayPlayer const& first, SelfPlayPlayer const& second,
+                    SelfPlaySettings const& settings, std::vector<Board> const& openings):
+   _settings(settings), _openings(openings), _observer(0), _next(0), _games(0)
+{
+   _players[0] = first;
+   _players[1] = second;
+}
+
+//------------------------------------------------------------------------------
+Sprt SelfPlay::run (unsigned games, unsigned threads, Sprt const& sprt) {
+   if (threads == 0)
+      threads = 1;
+   _next = 0;
+   _games = games;
+   _sprt = sprt;
+
+   std::vector<std::thread> workers;
+   for (unsigned i=1; i<threads; ++i)
+      workers.push_back(std::thread(&SelfPlay::work, this));
+   work();
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+   return _sprt;
+}
+
+//------------------------------------------------------------------------------
+void SelfPlay::work () {
+   Searcher searchers[2];
+   for (unsigned i=0; i<2; ++i) {
+      searchers[i].setOptions(_players[i].options);
+      searchers[i].tt().resize(_players[i].hash);
+   }
+
+   for (unsigned i = _next++; i < _games; i = _next++) {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (_sprt.decision() != 0)
+            return;
+      }
+      SelfPlayGame game;
+      game.index = i;
+      game.opening = (i / 2) % _openings.size();
+      game.firstIsLight = i % 2 == 0;
+      play(searchers, game);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _sprt.add(game.result);
+      if (_observer)
+         _observer->gameFinished(game, _sprt);
+   }
+}
+
+//------------------------------------------------------------------------------
+// Plays one game; searchers[0] plays the first player.
+void SelfPlay::play (Searcher* searchers, SelfPlayGame& game) {
+   Trace::Scope scope("self play", "game", game.index);
+   searchers[0].clear();
+   searchers[1].clear();
+   SearchLimits limits;
+   limits.nodes = _settings.nodes;
+   limits.moveTime = _settings.moveTime;
+
+   Game g;
+   g.setPosition(_openings[game.opening]);
+   // both games of a pair get the same random moves
+   playRandomPlies(g, _settings.randomPlies, game.index / 2);
+   // consecutive moves each side (by player) has scored as lost, or as drawn
+   unsigned losing[2] = { 0, 0 };
+   int lastScore[2] = { 0, 0 };
+   unsigned drawish = 0;
+
+   while (true) {
+      Board const& b = g.currentBoard();
+      bool light = b.pathDependence().lightMove();
+      unsigned mover = light == game.firstIsLight ? 0 : 1;
+      // +1 if the side to move wins, from the first player's side
+      int moverWins = mover == 0 ? 1 : -1;
+      game.plies = g.plies();
+
+      if (!hasLegalMove(b)) {
+         if (isCheckmate(b)) {
+            game.result = -moverWins;
+            game.reason = "checkmate";
+         } else {
+            game.result = 0;
+            game.reason = "stalemate";
+         }
+         return;
+      }
+      game.result = 0;
+      if (b.pathDependence().halfmoveClock() >= 100) {
+         game.reason = "fifty moves";
+         return;
+      }
+      if (isThreefold(g)) {
+         game.reason = "repetition";
+         return;
+      }
+      if (isInsufficientMaterial(b)) {
+         game.reason = "insufficient material";
+         return;
+      }
+      if (_settings.maxPlies && g.plies() >= _settings.maxPlies) {
+         game.reason = "move limit";
+         return;
+      }
+
+      Searcher& s = searchers[mover];
+      Move m = s.search(b, limits);
+      int score = s.score();
+
+      if (_settings.mateAdjudication && Score::isMate(score)) {
+         game.result = score > 0 ? moverWins : -moverWins;
+         game.reason = "adjudicated mate";
+         return;
+      }
+      if (_settings.resignScore) {
+         losing[mover] = score <= -_settings.resignScore ? losing[mover] + 1 : 0;
+         lastScore[mover] = score;
+         if (_settings.resignMoves && losing[mover] >= _settings.resignMoves
+             && lastScore[1 - mover] >= _settings.resignScore) {
+            game.result = -moverWins;
+            game.reason = "resignation";
+            return;
+         }
+      }
+      if (_settings.drawMoves && g.plies() >= _settings.drawPly) {
+         drawish = std::abs(score) <= _settings.drawScore ? drawish + 1 : 0;
+         if (drawish >= 2 * _settings.drawMoves) {
+            game.result = 0;
+            game.reason = "adjudicated draw";
+            return;
+         }
+      }
+      g.move(m);
+   }
+}
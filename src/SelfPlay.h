@@ -0,0 +1,177 @@
+//==============================================================================
+// SelfPlay.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef SELFPLAY
+#define SELFPLAY
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Search.h"
+
+
+//==============================================================================
+// Sequential Probability Ratio Test
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Decides between "the first player is elo0 stronger" (H0) and "it is elo1
+// stronger" (H1) as game results come in.
+/*
+ * The log likelihood ratio uses the usual normal approximation of the
+ * trinomial (win, draw, loss) model: with N games, mean score s and per game
+ * variance v, LLR = N (s1 - s0) (2s - s0 - s1) / 2v, where s0 and s1 are the
+ * mean scores the two Elo differences predict. The test stops once the LLR
+ * leaves [log(beta / (1 - alpha)), log((1 - beta) / alpha)].
+ */
+class Sprt {
+private:
+   double _elo0;
+   double _elo1;
+   double _alpha;
+   double _beta;
+   unsigned long long _wins;
+   unsigned long long _draws;
+   unsigned long long _losses;
+
+public:
+   Sprt (double elo0 = 0, double elo1 = 5, double alpha = 0.05, double beta = 0.05);
+   // +1 if the first player won, 0 for a draw, -1 if it lost
+   void add (int result);
+
+   unsigned long long wins   () const { return _wins; }
+   unsigned long long draws  () const { return _draws; }
+   unsigned long long losses () const { return _losses; }
+   unsigned long long games  () const { return _wins + _draws + _losses; }
+
+   double llr () const;
+   double lowerBound () const;
+   double upperBound () const;
+   // 1 if H1 is accepted, -1 if H0 is, 0 while more games are needed
+   int decision () const;
+   // the first player's Elo advantage implied by its score, and the margin of
+   // a 95% confidence interval around it
+   double elo () const;
+   double eloMargin () const;
+
+private:
+   void moments (double& score, double& variance) const;
+};
+
+
+//==============================================================================
+// Self Play
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// One side of a match: a name and search settings.
+struct SelfPlayPlayer {
+   std::string name;
+   SearchOptions options;
+   unsigned hash;    // megabytes of transposition table
+
+   SelfPlayPlayer (): name("default"), hash(16) {}
+};
+
+//------------------------------------------------------------------------------
+// The time control and adjudication rules both players play under. Zero turns
+// a rule off.
+struct SelfPlaySettings {
+   // per move; exactly one of these should be set
+   unsigned long long nodes;
+   long long moveTime;              // milliseconds
+   // random legal moves played from the opening before the players take
+   // over, so games from one opening differ between pairs
+   unsigned randomPlies;
+
+   // a mate score from the side to move ends the game
+   bool mateAdjudication;
+   // a side whose score stays at or below -resignScore for resignMoves of
+   // its moves, while its opponent agrees, loses
+   int resignScore;
+   unsigned resignMoves;
+   // from drawPly on, drawMoves moves in a row by each side scored within
+   // drawScore of zero make a draw
+   int drawScore;
+   unsigned drawMoves;
+   unsigned drawPly;
+   // longer games are drawn
+   unsigned maxPlies;
+
+   SelfPlaySettings ():
+      nodes(20000), moveTime(0), randomPlies(0),
+      mateAdjudication(true),
+      resignScore(600), resignMoves(3),
+      drawScore(10), drawMoves(8), drawPly(60),
+      maxPlies(400)
+   {}
+};
+
+//------------------------------------------------------------------------------
+// How one game went, from the first player's side.
+struct SelfPlayGame {
+   unsigned index;
+   unsigned opening;
+   bool firstIsLight;
+   int result;            // +1, 0 or -1 as for Sprt::add
+   unsigned plies;
+   char const* reason;    // ex, "checkmate", "adjudicated draw"
+};
+
+//------------------------------------------------------------------------------
+// Receives each game as it finishes, in finishing order, with the test
+// updated. Called with the match's lock held, so one call at a time.
+class SelfPlayObserver {
+public:
+   virtual ~SelfPlayObserver () {}
+   virtual void gameFinished (SelfPlayGame const& game, Sprt const& sprt) = 0;
+};
+
+//------------------------------------------------------------------------------
+// Plays a match between two players on a pool of threads.
+/*
+ * Each worker thread owns one Searcher per player (each with its own table,
+ * cleared before every game) and plays whole games, one at a time, pulling
+ * the next game number from a shared counter. Games come in pairs: game 2i
+ * and 2i + 1 start from the same opening (and the same random moves, if any)
+ * with colours reversed. Results go into the Sprt as they finish, and no new
+ * game starts once it has decided.
+ *
+ * Games end by the rules (checkmate, stalemate, the fifty move rule,
+ * threefold repetition, bare kings or a lone minor piece) or by
+ * adjudication (see SelfPlaySettings).
+ */
+class SelfPlay {
+private:
+   SelfPlayPlayer _players[2];
+   SelfPlaySettings _settings;
+   std::vector<Board> _openings;
+   SelfPlayObserver* _observer;
+
+   std::mutex _mutex;
+   std::atomic<unsigned> _next;
+   unsigned _games;
+   Sprt _sprt;
+
+   SelfPlay (SelfPlay const&);
+   void operator= (SelfPlay const&);
+
+public:
+   // openings must not be empty
+   SelfPlay (SelfPlayPlayer const& first, SelfPlayPlayer const& second,
+             SelfPlaySettings const& settings, std::vector<Board> const& openings);
+   void setObserver (SelfPlayObserver* observer) { _observer = observer; }
+
+   // plays up to games games (or until the test decides) and returns the test
+   Sprt run (unsigned games, unsigned threads, Sprt const& sprt);
+
+private:
+   void work ();
+   void play (Searcher* searchers, SelfPlayGame& game);
+};
+
+
+#endif
@@ -0,0 +1,555 @@
+//==============================================================================
+// Tablebase.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Tablebase.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+char const magic[4] = { 'G', 'T', 'B', 'L' };
+unsigned const version = 1;
+unsigned const headerSize = 16;
+
+Piece const extraPiece[TB::materialCount] = { PC::q0, PC::r0, PC::p0 };
+// values of the reduced square: the strong king's triangle, or the pawn's
+// ranks 2 to 7 on files a to d
+unsigned const reducedCount[TB::materialCount] = { 10, 10, 24 };
+
+inline unsigned tableSize (TB::Material m) { return 2 * reducedCount[m] * 64 * 64; }
+
+//------------------------------------------------------------------------------
+// The triangle a1-d1-d4 and the inverse numbering.
+signed char triangle[64];
+Square triangleSquares[10];
+
+struct TriangleInitializer {
+   TriangleInitializer () {
+      unsigned n = 0;
+      for (Square s=0; s<64; ++s)
+         triangle[s] = (file(s) <= 3 && rank(s) <= file(s)) ? (triangleSquares[n] = s, n++) : -1;
+   }
+} triangleInitializer;
+
+//------------------------------------------------------------------------------
+// A position of a table with the extra piece light.
+struct Placement {
+   Square strongKing;
+   Square weakKing;
+   Square piece;
+   bool strongToMove;
+};
+
+inline Square transpose (Square s) { return (file(s) << 3) | rank(s); }
+
+//------------------------------------------------------------------------------
+unsigned indexOf (TB::Material m, Placement const& p) {
+   Square k = p.strongKing;
+   Square w = p.weakKing;
+   Square x = p.piece;
+   unsigned side = p.strongToMove ? 0 : 1;
+   if (m == TB::kpk) {
+      if (file(x) > 3) { k ^= 7; w ^= 7; x ^= 7; }
+      unsigned reduced = (rank(x) - 1) * 4 + file(x);
+      return ((side * 24 + reduced) * 64 + k) * 64 + w;
+   }
+   if (file(k) > 3) { k ^= 7;  w ^= 7;  x ^= 7; }
+   if (rank(k) > 3) { k ^= 56; w ^= 56; x ^= 56; }
+   if (rank(k) > file(k)) { k = transpose(k); w = transpose(w); x = transpose(x); }
+   return ((side * 10 + triangle[k]) * 64 + w) * 64 + x;
+}
+
+//------------------------------------------------------------------------------
+void placementOf (TB::Material m, unsigned i, Placement& p) {
+   Square second = i & 63;
+   Square first = (i >> 6) & 63;
+   unsigned reduced = (i >> 12) % reducedCount[m];
+   p.strongToMove = (i >> 12) / reducedCount[m] == 0;
+   if (m == TB::kpk) {
+      p.piece = (reduced / 4 + 1) * 8 + reduced % 4;
+      p.strongKing = first;
+      p.weakKing = second;
+   } else {
+      p.strongKing = triangleSquares[reduced];
+      p.weakKing = first;
+      p.piece = second;
+   }
+}
+
+//------------------------------------------------------------------------------
+inline bool adjacent (Square a, Square b) {
+   int df = static_cast<int>(file(a)) - static_cast<int>(file(b));
+   int dr = static_cast<int>(rank(a)) - static_cast<int>(rank(b));
+   return -1 <= df && df <= 1 && -1 <= dr && dr <= 1;
+}
+
+//------------------------------------------------------------------------------
+// Sets up board with nothing left to castle; false if the placement can't
+// occur (the side that just moved can't be left in check).
+bool setUp (TB::Material m, Placement const& p, Board& board) {
+   if (p.strongKing == p.weakKing || p.piece == p.strongKing || p.piece == p.weakKing
+       || adjacent(p.strongKing, p.weakKing)) {
+      return false;
+   }
+   board.b.clear();
+   board.b.set(p.strongKing, PC::k0);
+   board.b.set(p.weakKing, PC::k1);
+   board.b.set(p.piece, extraPiece[m]);
+   board.pd.newGame();
+   if (!p.strongToMove)
+      board.pd.swapTurn();
+   board.pd.lightKingMoved();
+   board.pd.lightRook0Moved();
+   board.pd.lightRook7Moved();
+   board.pd.darkKingMoved();
+   board.pd.darkRook0Moved();
+   board.pd.darkRook7Moved();
+   board.finishSetup();
+   PathIndependentArbiter arbiter;
+   return !arbiter.isInCheck(board.b, !p.strongToMove);
+}
+
+//------------------------------------------------------------------------------
+// Finds the (at most three) pieces of b; false if there are more.
+struct Pieces {
+   Square lightKing;
+   Square darkKing;
+   Square extra;
+   Piece extraPiece;
+   unsigned count;
+};
+
+bool findPieces (BitBoard const& bb, Pieces& pieces) {
+   pieces.count = 0;
+   pieces.extraPiece = PC::c0;
+   for (PieceItr itr(bb, PieceItr::all_pieces); itr.valid(); ++itr) {
+      if (++pieces.count > 3)
+         return false;
+      Piece p = itr.piece();
+      if (p == PC::k0)
+         pieces.lightKing = itr.square();
+      else if (p == PC::k1)
+         pieces.darkKing = itr.square();
+      else {
+         pieces.extra = itr.square();
+         pieces.extraPiece = p;
+      }
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// results while generating
+unsigned char const unknown = 4;
+
+// a child outside the table being generated is stored as its final value
+unsigned const fixedChild = 0x80000000u;
+
+//------------------------------------------------------------------------------
+// Retrograde analysis of one table.
+/*
+ * Instead of generating unmoves, every position's children are listed once up
+ * front (as indices into this table, or as final values if they leave it by a
+ * capture or promotion). Then each pass resolves, from the previous pass's
+ * values only, the positions whose distance is the pass number: a win if some
+ * child is lost one ply sooner, a loss if every child is won and the slowest
+ * of them one ply sooner. Passes split the table over threads, and whatever is
+ * still unknown once passes stop resolving anything is a draw.
+ */
+class Solver {
+public:
+   TB::Material material;
+   unsigned size;
+   std::vector<unsigned char> result;
+   std::vector<unsigned char> distance;
+   std::vector<unsigned char> nextResult;
+   std::vector<unsigned char> nextDistance;
+   std::vector<unsigned> first;
+   std::vector<unsigned> children;
+   // no pass before this one can still depend on a fixed child
+   unsigned horizon;
+   // finished tables, by material (null if not yet solved)
+   Solver const* const* solved;
+
+   Solver (TB::Material m, Solver const* const* s):
+      material(m), size(tableSize(m)), horizon(0), solved(s) {}
+
+   void solve (unsigned threads);
+   unsigned char longest () const;
+
+   // lists the children of [begin, end) into the given slice
+   struct Slice {
+      std::vector<unsigned char> count;
+      std::vector<unsigned> children;
+      unsigned horizon;
+   };
+   void link (unsigned begin, unsigned end, Slice& slice);
+   // resolves what pass ply can in [begin, end); returns how many it resolved
+   unsigned step (unsigned ply, unsigned begin, unsigned end);
+
+private:
+   unsigned child (Board const& b, unsigned& horizon) const;
+};
+
+//------------------------------------------------------------------------------
+unsigned Solver::child (Board const& b, unsigned& horizon) const {
+   Pieces pieces;
+   findPieces(b.bitboard(), pieces);
+   if (pieces.count == 2)
+      return fixedChild | (TB::draw << 8);
+   Placement p = { pieces.lightKing, pieces.darkKing, pieces.extra,
+                   b.pathDependence().lightMove() };
+   if (pieces.extraPiece == extraPiece[material])
+      return indexOf(material, p);
+
+   TB::Material m = pieces.extraPiece == PC::q0 ? TB::kqk
+                  : pieces.extraPiece == PC::r0 ? TB::krk : TB::materialCount;
+   if (m == TB::materialCount)
+      return fixedChild | (TB::draw << 8);
+   unsigned i = indexOf(m, p);
+   unsigned d = solved[m]->distance[i];
+   if (d + 1 > horizon)
+      horizon = d + 1;
+   return fixedChild | (solved[m]->result[i] << 8) | d;
+}
+
+//------------------------------------------------------------------------------
+void Solver::link (unsigned begin, unsigned end, Slice& slice) {
+   slice.count.assign(end - begin, 0);
+   slice.horizon = 0;
+   Board b, c;
+   MoveList list;
+   PathIndependentArbiter arbiter;
+   for (unsigned i=begin; i<end; ++i) {
+      Placement p;
+      placementOf(material, i, p);
+      if (!setUp(material, p, b)) {
+         result[i] = TB::invalid;
+         continue;
+      }
+      generateLegalMoves(b, list);
+      if (list.size == 0) {
+         result[i] = arbiter.isInCheck(b.bitboard(), p.strongToMove) ? TB::loss : TB::draw;
+         continue;
+      }
+      for (unsigned j=0; j<list.size; ++j) {
+         b.realize(list.move[j], c);
+         slice.children.push_back(child(c, slice.horizon));
+      }
+      slice.count[i - begin] = list.size;
+   }
+}
+
+//------------------------------------------------------------------------------
+unsigned Solver::step (unsigned ply, unsigned begin, unsigned end) {
+   unsigned resolved = 0;
+   for (unsigned i=begin; i<end; ++i) {
+      if (result[i] != unknown)
+         continue;
+      unsigned quickestLoss = ply;
+      unsigned slowestWin = 0;
+      bool allWon = true;
+      for (unsigned j=first[i]; j<first[i + 1]; ++j) {
+         unsigned c = children[j];
+         unsigned r, d;
+         if (c & fixedChild) {
+            r = (c >> 8) & 0xff;
+            d = c & 0xff;
+         } else {
+            r = result[c];
+            d = distance[c];
+         }
+         if (r == TB::loss) {
+            if (d < quickestLoss)
+               quickestLoss = d;
+         } else if (r == TB::win) {
+            if (d > slowestWin)
+               slowestWin = d;
+         } else {
+            allWon = false;
+         }
+      }
+      if (quickestLoss < ply) {
+         nextResult[i] = TB::win;
+         nextDistance[i] = quickestLoss + 1;
+         ++resolved;
+      } else if (allWon && slowestWin < ply) {
+         nextResult[i] = TB::loss;
+         nextDistance[i] = slowestWin + 1;
+         ++resolved;
+      }
+   }
+   return resolved;
+}
+
+//------------------------------------------------------------------------------
+void linkRange (Solver* solver, unsigned begin, unsigned end, Solver::Slice* slice) {
+   solver->link(begin, end, *slice);
+}
+
+void stepRange (Solver* solver, unsigned ply, unsigned begin, unsigned end, unsigned* resolved) {
+   *resolved = solver->step(ply, begin, end);
+}
+
+//------------------------------------------------------------------------------
+void Solver::solve (unsigned threads) {
+   result.assign(size, unknown);
+   distance.assign(size, 0);
+
+   // children, listed in contiguous ranges on every thread
+   std::vector<Slice> slices(threads);
+   std::vector<std::thread> workers;
+   for (unsigned t=1; t<threads; ++t) {
+      workers.push_back(std::thread(linkRange, this, size / threads * t,
+                                    t + 1 < threads ? size / threads * (t + 1) : size,
+                                    &slices[t]));
+   }
+   link(0, threads > 1 ? size / threads : size, slices[0]);
+   for (unsigned t=0; t<workers.size(); ++t)
+      workers[t].join();
+
+   first.resize(size + 1);
+   unsigned i = 0;
+   first[0] = 0;
+   for (unsigned t=0; t<threads; ++t) {
+      for (unsigned j=0; j<slices[t].count.size(); ++j, ++i)
+         first[i + 1] = first[i] + slices[t].count[j];
+      children.insert(children.end(), slices[t].children.begin(), slices[t].children.end());
+      if (slices[t].horizon > horizon)
+         horizon = slices[t].horizon;
+      std::vector<unsigned>().swap(slices[t].children);
+   }
+
+   std::vector<unsigned> resolved(threads);
+   for (unsigned ply=1; ; ++ply) {
+      nextResult = result;
+      nextDistance = distance;
+      workers.clear();
+      for (unsigned t=1; t<threads; ++t) {
+         workers.push_back(std::thread(stepRange, this, ply, size / threads * t,
+                                       t + 1 < threads ? size / threads * (t + 1) : size,
+                                       &resolved[t]));
+      }
+      resolved[0] = step(ply, 0, threads > 1 ? size / threads : size);
+      unsigned total = resolved[0];
+      for (unsigned t=0; t<workers.size(); ++t) {
+         workers[t].join();
+         total += resolved[t + 1];
+      }
+      result.swap(nextResult);
+      distance.swap(nextDistance);
+      if (total == 0 && ply >= horizon)
+         break;
+   }
+
+   for (unsigned i=0; i<size; ++i) {
+      if (result[i] == unknown)
+         result[i] = TB::draw;
+   }
+   std::vector<unsigned>().swap(first);
+   std::vector<unsigned>().swap(children);
+   std::vector<unsigned char>().swap(nextResult);
+   std::vector<unsigned char>().swap(nextDistance);
+}
+
+//------------------------------------------------------------------------------
+unsigned char Solver::longest () const {
+   unsigned char d = 0;
+   for (unsigned i=0; i<size; ++i) {
+      if (distance[i] > d)
+         d = distance[i];
+   }
+   return d;
+}
+
+//------------------------------------------------------------------------------
+inline unsigned resultsBytes (unsigned entries) { return ((entries + 3) / 4 + 7) & ~7u; }
+// distances are read 8 bytes at a time, so the last one is padded out
+inline unsigned long long distancesBytes (unsigned entries, unsigned bits) {
+   return (static_cast<unsigned long long>(entries) * bits + 7) / 8 + 8;
+}
+
+//------------------------------------------------------------------------------
+bool write (char const* path, Solver const& solver) {
+   unsigned bits = 1;
+   while ((1u << bits) <= solver.longest())
+      ++bits;
+
+   std::vector<unsigned char> results(resultsBytes(solver.size), 0);
+   std::vector<unsigned char> distances(distancesBytes(solver.size, bits), 0);
+   for (unsigned i=0; i<solver.size; ++i) {
+      results[i >> 2] |= solver.result[i] << ((i & 3) * 2);
+      unsigned long long bit = static_cast<unsigned long long>(i) * bits;
+      unsigned value = solver.distance[i] << (bit & 7);
+      for (unsigned long long byte = bit >> 3; value; ++byte, value >>= 8)
+         distances[byte] |= value & 0xff;
+   }
+
+   std::FILE* file = std::fopen(path, "wb");
+   if (!file)
+      return false;
+   unsigned header[4] = { 0, version, solver.size, solver.material | (bits << 8) };
+   memcpy(header, magic, 4);
+   bool ok = std::fwrite(header, headerSize, 1, file) == 1
+          && std::fwrite(&results[0], results.size(), 1, file) == 1
+          && std::fwrite(&distances[0], distances.size(), 1, file) == 1;
+   ok = std::fclose(file) == 0 && ok;
+   return ok;
+}
+
+//------------------------------------------------------------------------------
+std::string pathOf (char const* directory, TB::Material m) {
+   std::string path(directory);
+   if (!path.empty() && path[path.size() - 1] != '/')
+      path += '/';
+   return path + TB::fileName(m);
+}
+
+}
+
+
+//==============================================================================
+// Tablebases
+//==============================================================================
+
+//------------------------------------------------------------------------------
+char const* TB::fileName (Material m) {
+   static char const* const names[materialCount] = { "kqk.gtb", "krk.gtb", "kpk.gtb" };
+   return names[m];
+}
+
+//------------------------------------------------------------------------------
+unsigned Tablebases::load (char const* directory) {
+   close();
+   unsigned n = 0;
+   for (unsigned m=0; m<TB::materialCount; ++m) {
+      Table& t = _tables[m];
+      if (!t.file.open(pathOf(directory, static_cast<TB::Material>(m)).c_str()))
+         continue;
+      unsigned header[4] = { 0, 0, 0, 0 };
+      if (t.file.size() >= headerSize)
+         memcpy(header, t.file.begin(), headerSize);
+      unsigned bits = header[3] >> 8;
+      if (memcmp(header, magic, 4) != 0 || header[1] != version
+          || header[2] != tableSize(static_cast<TB::Material>(m))
+          || (header[3] & 0xff) != m || bits == 0 || bits > 8
+          || t.file.size() != headerSize + resultsBytes(header[2])
+                              + distancesBytes(header[2], bits)) {
+         t.file.close();
+         continue;
+      }
+      t.entries = header[2];
+      t.distanceBits = bits;
+      t.results = reinterpret_cast<unsigned char const*>(t.file.begin()) + headerSize;
+      t.distances = t.results + resultsBytes(t.entries);
+      ++n;
+   }
+   return n;
+}
+
+//------------------------------------------------------------------------------
+void Tablebases::close () {
+   for (unsigned m=0; m<TB::materialCount; ++m) {
+      _tables[m].file.close();
+      _tables[m].results = 0;
+      _tables[m].distances = 0;
+   }
+}
+
+//------------------------------------------------------------------------------
+bool Tablebases::probe (Board const& b, unsigned& result, unsigned& distance) const {
+   BitBoard const& bb = b.bitboard();
+   Pieces pieces;
+   if (!findPieces(bb, pieces) || pieces.count != 3)
+      return false;
+
+   // the tables have the extra piece light: otherwise look at the mirror image
+   bool light = isLightPiece(pieces.extraPiece);
+   Piece extra = light ? pieces.extraPiece : pieces.extraPiece - PC::p1 + PC::p0;
+   TB::Material m = extra == PC::q0 ? TB::kqk
+                  : extra == PC::r0 ? TB::krk
+                  : extra == PC::p0 ? TB::kpk : TB::materialCount;
+   if (m == TB::materialCount || !_tables[m].results)
+      return false;
+
+   // a rook still able to castle isn't covered
+   PathDependence const& pd = b.pathDependence();
+   if (m == TB::krk) {
+      if (light && !pd.lightKing() && bb.get(4) == PC::k0
+          && ((!pd.lightRook0() && bb.get(0) == PC::r0) || (!pd.lightRook7() && bb.get(7) == PC::r0))) {
+         return false;
+      }
+      if (!light && !pd.darkKing() && bb.get(60) == PC::k1
+          && ((!pd.darkRook0() && bb.get(56) == PC::r1) || (!pd.darkRook7() && bb.get(63) == PC::r1))) {
+         return false;
+      }
+   }
+
+   Placement p;
+   if (light) {
+      p.strongKing = pieces.lightKing;
+      p.weakKing = pieces.darkKing;
+      p.piece = pieces.extra;
+      p.strongToMove = pd.lightMove();
+   } else {
+      p.strongKing = pieces.darkKing ^ 56;
+      p.weakKing = pieces.lightKing ^ 56;
+      p.piece = pieces.extra ^ 56;
+      p.strongToMove = !pd.lightMove();
+   }
+   if (m == TB::kpk && (rank(p.piece) == 0 || rank(p.piece) == 7))
+      return false;
+
+   Table const& t = _tables[m];
+   unsigned i = indexOf(m, p);
+   result = (t.results[i >> 2] >> ((i & 3) * 2)) & 3;
+   if (result == TB::invalid)
+      return false;
+   unsigned long long bit = static_cast<unsigned long long>(i) * t.distanceBits;
+   unsigned long long word;
+   memcpy(&word, t.distances + (bit >> 3), 8);
+   distance = (word >> (bit & 7)) & ((1u << t.distanceBits) - 1);
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// KPK promotes into the others, so it's solved last.
+bool Tablebases::generate (char const* directory, unsigned threads, bool verbose) {
+   if (threads == 0)
+      threads = 1;
+   Solver* solvers[TB::materialCount] = { 0, 0, 0 };
+   bool ok = true;
+   for (unsigned m=0; m<TB::materialCount && ok; ++m) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      Solver* solver = new Solver(static_cast<TB::Material>(m), solvers);
+      solver->solve(threads);
+      solvers[m] = solver;
+      ok = write(pathOf(directory, solver->material).c_str(), *solver);
+      if (verbose) {
+         unsigned counts[4] = { 0, 0, 0, 0 };
+         for (unsigned i=0; i<solver->size; ++i)
+            ++counts[solver->result[i]];
+         double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         std::printf("%s: %u positions, %u wins, %u losses, %u draws, %u invalid, "
+                     "longest mate %u plies, %.2f s%s\n",
+                     TB::fileName(solver->material), solver->size, counts[TB::win],
+                     counts[TB::loss], counts[TB::draw], counts[TB::invalid],
+                     solver->longest(), seconds, ok ? "" : " (not written)");
+      }
+   }
+   for (unsigned m=0; m<TB::materialCount; ++m)
+      delete solvers[m];
+   return ok;
+}
@@ -0,0 +1,78 @@
+//==============================================================================
+// Tablebase.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef TABLEBASE
+#define TABLEBASE
+
+#include "Chess.h"
+#include "MappedFile.h"
+
+
+//==============================================================================
+// Endgame Tablebases
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Perfect play for king and queen, rook or pawn against a lone king.
+/*
+ * Each table covers one piece set with the extra piece light (positions with
+ * it dark are probed mirrored) and holds, for every position, the result for
+ * the side to move and its distance to mate in plies. Castling rights aren't
+ * covered, and neither is the fifty move rule.
+ *
+ * Positions are indexed by side to move, then a reduced square, then the other
+ * two squares. Without pawns the strong king is brought into the a1-d1-d4
+ * triangle (8 fold symmetry); with a pawn it's brought onto files a to d.
+ *
+ * Files (ex, "kqk.gtb") hold a header, the results at 2 bits per position and
+ * the distances at as few bits as the largest one needs. They're mapped, so a
+ * probe reads two entries in place and allocates nothing.
+ */
+namespace TB {
+   // results, for the side to move
+   static const unsigned draw    = 0;
+   static const unsigned win     = 1;
+   static const unsigned loss    = 2;
+   static const unsigned invalid = 3;
+
+   enum Material { kqk, krk, kpk, materialCount };
+   char const* fileName (Material m);
+}
+
+//------------------------------------------------------------------------------
+class Tablebases {
+private:
+   struct Table {
+      MappedFile file;
+      unsigned char const* results;
+      unsigned char const* distances;
+      unsigned entries;
+      unsigned distanceBits;
+      Table (): results(0), distances(0), entries(0), distanceBits(0) {}
+   };
+   Table _tables[TB::materialCount];
+
+   Tablebases (Tablebases const&);
+   void operator= (Tablebases const&);
+
+public:
+   Tablebases () {}
+
+   // loads the tables found in directory; returns the number loaded
+   unsigned load (char const* directory);
+   void close ();
+   bool loaded (TB::Material m) const { return _tables[m].results != 0; }
+
+   // false if b's piece set isn't loaded (or it can still castle); otherwise
+   // result is one of TB::draw, win or loss and distance is in plies
+   bool probe (Board const& b, unsigned& result, unsigned& distance) const;
+
+   // builds every table by retrograde analysis on the given number of threads
+   // and writes them to directory; progress goes to stdout if verbose
+   static bool generate (char const* directory, unsigned threads, bool verbose);
+};
+
+
+#endif
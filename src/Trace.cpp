@@ -0,0 +1,207 @@
+//==============================================================================
+// Trace.cpp
+// created October 19, 2026
+//==============================================================================
+
+#include "Trace.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace {
+
+//------------------------------------------------------------------------------
+// events each thread keeps (a power of two)
+unsigned long long const ringSize = 1 << 14;
+
+struct Event {
+   char const* category;
+   char const* name;
+   long long start;
+   long long duration;   // -1 for instants
+   long long arg;
+};
+
+//------------------------------------------------------------------------------
+// head counts every event the thread has recorded; event i lives at
+// i % ringSize until overwritten. Events before first were recorded before
+// the trace started.
+struct Ring {
+   std::atomic<unsigned long long> head;
+   std::atomic<unsigned long long> first;
+   std::atomic<char const*> threadName;
+   unsigned id;
+   Event events[ringSize];
+};
+
+// every ring ever attached; never freed, since a trace may be written after a
+// thread is gone
+std::mutex ringsMutex;
+std::vector<Ring*> rings;
+
+thread_local Ring* current = 0;
+// kept apart from the ring, so naming a thread that never records costs nothing
+thread_local char const* currentName = 0;
+
+//------------------------------------------------------------------------------
+Ring& attach () {
+   Ring* ring = new Ring();
+   ring->head = 0;
+   ring->first = 0;
+   ring->threadName = currentName;
+   std::lock_guard<std::mutex> lock(ringsMutex);
+   ring->id = rings.size() + 1;
+   rings.push_back(ring);
+   current = ring;
+   return *ring;
+}
+
+inline Ring& local () { return current ? *current : attach(); }
+
+//------------------------------------------------------------------------------
+inline void push (Event const& e) {
+   Ring& ring = local();
+   unsigned long long head = ring.head.load(std::memory_order_relaxed);
+   ring.events[head & (ringSize - 1)] = e;
+   ring.head.store(head + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Names come from our own literals, but escape them anyway to keep the JSON whole.
+void writeString (std::FILE* file, char const* s) {
+   std::fputc('"', file);
+   for ( ; *s; ++s) {
+      if (*s == '"' || *s == '\\')
+         std::fputc('\\', file);
+      if (static_cast<unsigned char>(*s) >= 0x20)
+         std::fputc(*s, file);
+   }
+   std::fputc('"', file);
+}
+
+}
+
+
+//==============================================================================
+// Timeline Tracing
+//==============================================================================
+
+std::atomic<bool> Trace::active(false);
+
+//------------------------------------------------------------------------------
+long long Trace::now () {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+   ).count();
+}
+
+//------------------------------------------------------------------------------
+void Trace::start () {
+   std::lock_guard<std::mutex> lock(ringsMutex);
+   for (unsigned i=0; i<rings.size(); ++i)
+      rings[i]->first = rings[i]->head.load(std::memory_order_acquire);
+   active = true;
+}
+
+//------------------------------------------------------------------------------
+void Trace::stop () {
+   active = false;
+}
+
+//------------------------------------------------------------------------------
+void Trace::nameThread (char const* name) {
+   currentName = name;
+   if (current)
+      current->threadName = name;
+}
+
+//------------------------------------------------------------------------------
+void Trace::record (char const* category, char const* name, long long start, long long arg) {
+   Event e = { category, name, start, now() - start, arg };
+   push(e);
+}
+
+//------------------------------------------------------------------------------
+void Trace::instant (char const* category, char const* name, long long arg) {
+   if (!on())
+      return;
+   Event e = { category, name, now(), -1, arg };
+   push(e);
+}
+
+//------------------------------------------------------------------------------
+// Timestamps are written in microseconds, as Chrome expects, relative to the
+// earliest event.
+bool Trace::write (char const* path) {
+   std::vector<std::pair<unsigned, Event> > events;
+   std::vector<std::pair<unsigned, char const*> > names;
+   {
+      std::lock_guard<std::mutex> lock(ringsMutex);
+      for (unsigned i=0; i<rings.size(); ++i) {
+         Ring& ring = *rings[i];
+         unsigned long long head = ring.head.load(std::memory_order_acquire);
+         unsigned long long first = ring.first.load(std::memory_order_relaxed);
+         if (head - first > ringSize)
+            first = head - ringSize;
+         unsigned long long copied = events.size();
+         for (unsigned long long j=first; j<head; ++j)
+            events.push_back(std::make_pair(ring.id, ring.events[j & (ringSize - 1)]));
+         // the owner may have lapped the copy; drop what it overwrote, and the
+         // slot it may be writing now (event after), which holds a kept event.
+         // The fence keeps the copies above from moving past the reload.
+         std::atomic_thread_fence(std::memory_order_acquire);
+         unsigned long long after = ring.head.load(std::memory_order_relaxed);
+         if (after + 1 - first > ringSize) {
+            unsigned long long lost = after + 1 - first - ringSize;
+            if (lost > head - first)
+               lost = head - first;
+            events.erase(events.begin() + copied, events.begin() + copied + lost);
+         }
+         if (ring.threadName.load())
+            names.push_back(std::make_pair(ring.id, ring.threadName.load()));
+      }
+   }
+
+   std::FILE* file = std::fopen(path, "w");
+   if (!file)
+      return false;
+   long long origin = 0;
+   for (unsigned i=0; i<events.size(); ++i) {
+      if (i == 0 || events[i].second.start < origin)
+         origin = events[i].second.start;
+   }
+
+   std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+   char const* separator = "\n";
+   for (unsigned i=0; i<names.size(); ++i) {
+      std::fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                   "\"args\": {\"name\": ", separator, names[i].first);
+      writeString(file, names[i].second);
+      std::fprintf(file, "}}");
+      separator = ",\n";
+   }
+   for (unsigned i=0; i<events.size(); ++i) {
+      Event const& e = events[i].second;
+      std::fprintf(file, "%s{\"name\": ", separator);
+      writeString(file, e.name);
+      std::fprintf(file, ", \"cat\": ");
+      writeString(file, e.category);
+      std::fprintf(file, ", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, ", events[i].first,
+                   (e.start - origin) / 1000.0);
+      if (e.duration < 0)
+         std::fprintf(file, "\"ph\": \"i\", \"s\": \"t\"");
+      else
+         std::fprintf(file, "\"ph\": \"X\", \"dur\": %.3f", e.duration / 1000.0);
+      std::fprintf(file, ", \"args\": {\"value\": %lld}}", e.arg);
+      separator = ",\n";
+   }
+   std::fprintf(file, "\n]}\n");
+   bool ok = !std::ferror(file);
+   return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,79 @@
+//==============================================================================
+// Trace.h
+// created October 19, 2026
+//==============================================================================
+
+#ifndef TRACE
+#define TRACE
+
+#include <atomic>
+
+
+//==============================================================================
+// Timeline Tracing
+//==============================================================================
+
+//------------------------------------------------------------------------------
+// Timestamped events for finding latency spikes, viewable in chrome://tracing
+// or Perfetto.
+/*
+ * Tracing is always compiled in but starts switched off; then a Scope costs a
+ * single load and branch. Once started, each thread records into its own ring
+ * buffer, allocated on its first event. Only the owning thread writes a ring,
+ * publishing each event by advancing the ring's head, so recording takes no
+ * locks. A full ring overwrites its oldest events.
+ *
+ * write() snapshots every ring (safe while threads are still recording; any
+ * events overwritten during the copy are dropped) and writes them as Chrome
+ * trace JSON. Rings outlive their threads, like Counters' blocks.
+ *
+ * Names and categories must be string literals (or otherwise outlive the
+ * trace), since only the pointers are recorded.
+ */
+namespace Trace {
+   extern std::atomic<bool> active;
+   inline bool on () { return active.load(std::memory_order_relaxed); }
+
+   // start forgets everything recorded before it
+   void start ();
+   void stop ();
+   // writes the events recorded since start; false if the file can't be written
+   bool write (char const* path);
+   // the name the calling thread is shown under
+   void nameThread (char const* name);
+
+   // nanoseconds on a monotonic clock
+   long long now ();
+   void record (char const* category, char const* name, long long start, long long arg);
+   // an event with no duration (ex, a command arriving)
+   void instant (char const* category, char const* name, long long arg = 0);
+
+   //---------------------------------------------------------------------------
+   // Records an event lasting from its construction to its destruction.
+   class Scope {
+   private:
+      char const* _category;
+      char const* _name;
+      long long _start;
+      long long _arg;
+
+      Scope (Scope const&);
+      void operator= (Scope const&);
+
+   public:
+      Scope (char const* category, char const* name, long long arg = 0):
+         _category(category), _name(on() ? name : 0)
+      {
+         if (_name) {
+            _start = now();
+            _arg = arg;
+         }
+      }
+      ~Scope () { if (_name) record(_category, _name, _start, _arg); }
+      // shown in the event's args (ex, the depth of an iteration)
+      void setArg (long long arg) { _arg = arg; }
+   };
+}
+
+
+#endif
@@ -3,70 +3,1233 @@
 // created November 18, 2012
 //==============================================================================
 
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
 #include "Chess.h"
+#include "GambitInterface.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+#include "PositionFile.h"
+#include "Fen.h"
+#include "GameArchive.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "OpeningTree.h"
+#include "AnalysisCache.h"
 #include "AsciiBoard.h"
-#include "MoveParser.h"
-
-using namespace std;
+#include "MateSolver.h"
+#include "Perft.h"
+#include "SelfPlay.h"
+#include "BatchAnalysis.h"
+#include "Trace.h"
 
 
 //------------------------------------------------------------------------------
-int main (int argc, char** argv) {
+// pgn <file> [threads]: replays every game in a PGN file and reports throughput.
+// A file that can't be mapped (ex, "-" for stdin) is read in chunks on one thread.
+int replayPgn (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s pgn <file> [threads]\n", argv[0]);
+      return 1;
+   }
+   unsigned threads = argc > 3 ? atoi(argv[3]) : 1;
 
-   Board b;
-   b.setupNewGame();
-   //Board b2;
-
-
-   b.clearHashState();
-   b.b.set(5, PC::c0);
-   b.b.set(6, PC::r0);
-   b.b.set(7, PC::c0);
-
-   b.b.set(49, PC::c0);
-   b.b.set(25, PC::p1);
-
-   b.testSpecialMoves();
-   b.findCodes();
-   //cout << AsciiBoard(b.bitboard());
-
-   Board b2;
-   Generator gen;
-   gen.setBoard(b);
-
-   gen.setSource(10);
-   ++gen;
-   b.realize(gen, b2);
-   b = b2;
-   cout << AsciiBoard(b.bitboard());
- 
-   gen.setBoard(b);
-   gen.setSource(25);
-   while (gen.valid()) {
-      b.realize(gen, b2);
-      cout << AsciiBoard(b2.bitboard());
-      ++gen;
-   }
-
-   //Game game;
-   //MoveParser parser;
-
-   /*
-   cout << AsciiBoard(b.bitboard());
-   if (b.pd.lightMove()) {
-      cout << "Light's move:\n";
+   PgnStats stats;
+   long long start = millisecondsNow();
+   MappedFile file;
+   if (strcmp(argv[2], "-") != 0 && file.open(argv[2])) {
+      stats = Pgn::replay(file.begin(), file.end(), threads);
    } else {
-      cout << "Dark's move:\n";
+      int fd = strcmp(argv[2], "-") == 0 ? 0 : open(argv[2], O_RDONLY);
+      PgnReader reader;
+      if (fd < 0 || !reader.read(fd)) {
+         fprintf(stderr, "can't read %s\n", argv[2]);
+         return 1;
+      }
+      stats = reader.stats();
+   }
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   if (seconds <= 0)
+      seconds = 0.001;
+
+   printf("games %llu moves %llu errors %llu in %.3f s\n",
+          stats.games, stats.moves, stats.errors, seconds);
+   printf("ending in checkmate %llu, stalemate %llu\n", stats.checkmates, stats.stalemates);
+   printf("%.0f games/s, %.0f moves/s, %.1f MB/s\n",
+          stats.games / seconds, stats.moves / seconds, stats.bytes / seconds / 1e6);
+   return stats.errors ? 2 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Writes every position of the games it's shown.
+class PositionExtractor: public PgnObserver {
+public:
+   PositionWriter& writer;
+   PositionExtractor (PositionWriter& w): writer(w) {}
+   void gameStarted (Board const& start) { writer.write(start); }
+   void movePlayed (Game const& game, Move const& move) { writer.write(game.currentBoard()); }
+};
+
+//------------------------------------------------------------------------------
+// pack <in> <out>: converts FEN lines, or every position of every game in a
+// file ending in ".pgn", to a position file.
+int packPositions (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s pack <fen or pgn file> <position file>\n", argv[0]);
+      return 1;
+   }
+   MappedFile in;
+   PositionWriter out;
+   if (!in.open(argv[2]) || !out.open(argv[3])) {
+      fprintf(stderr, "can't open %s or %s\n", argv[2], argv[3]);
+      return 1;
    }
-   Generator const& gen = parser.getMove(b);
-   if (gen.valid()) {
-      b.realize(gen, b2);
-      cout << AsciiBoard(b2.bitboard());
+
+   unsigned long long skipped = 0;
+   unsigned length = strlen(argv[2]);
+   if (length > 4 && strcmp(argv[2] + length - 4, ".pgn") == 0) {
+      PositionExtractor extractor(out);
+      PgnReader reader;
+      reader.setObserver(&extractor);
+      reader.read(in.begin(), in.end());
+      skipped = reader.stats().errors;
    } else {
-      cout << "Could not parse your move." << '\n';
+      Board b;
+      for (char const* p = in.begin(); p < in.end(); ) {
+         char const* line = p;
+         while (p < in.end() && *p != '\n')
+            ++p;
+         if (p > line && Fen::read(line, p, b))
+            out.write(b);
+         else if (p > line)
+            ++skipped;
+         ++p;
+      }
+   }
+   unsigned long long count = out.count();
+   if (!out.close()) {
+      fprintf(stderr, "can't write %s\n", argv[3]);
+      return 1;
+   }
+   printf("wrote %llu positions (%llu bytes each), skipped %llu\n",
+          count, static_cast<unsigned long long>(sizeof(PositionRecord)), skipped);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// Expands every record into a Board and counts what it finds.
+class PositionCounter: public PositionVisitor {
+public:
+   unsigned long long positions;
+   unsigned long long lightToMove;
+   unsigned long long pieces;
+   Board b;
+   PositionCounter (): positions(0), lightToMove(0), pieces(0) {}
+   void visit (unsigned long long index, PositionRecord const& record) {
+      record.unpack(b);
+      ++positions;
+      lightToMove += b.pathDependence().lightMove();
+      for (PieceItr itr(b.bitboard(), PieceItr::all_pieces); itr.valid(); ++itr)
+         ++pieces;
+   }
+};
+
+//------------------------------------------------------------------------------
+// scan <position file> [threads]: reads every record and reports throughput.
+int scanPositions (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s scan <position file> [threads]\n", argv[0]);
+      return 1;
+   }
+   unsigned threads = argc > 3 ? atoi(argv[3]) : 1;
+   if (threads == 0)
+      threads = 1;
+   PositionFile file;
+   if (!file.open(argv[2])) {
+      fprintf(stderr, "%s is not a position file\n", argv[2]);
+      return 1;
+   }
+
+   std::vector<PositionCounter> counters(threads);
+   std::vector<PositionVisitor*> visitors(threads);
+   for (unsigned i=0; i<threads; ++i)
+      visitors[i] = &counters[i];
+   long long start = millisecondsNow();
+   file.scan(threads, &visitors[0]);
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   if (seconds <= 0)
+      seconds = 0.001;
+
+   PositionCounter total;
+   for (unsigned i=0; i<threads; ++i) {
+      total.positions += counters[i].positions;
+      total.lightToMove += counters[i].lightToMove;
+      total.pieces += counters[i].pieces;
+   }
+   printf("positions %llu light to move %llu pieces %llu in %.3f s\n",
+          total.positions, total.lightToMove, total.pieces, seconds);
+   printf("%.0f positions/s\n", total.positions / seconds);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// Adds every complete game it's shown to an archive, counting the moves it
+// stored.
+class GameArchiver: public PgnObserver {
+public:
+   GameArchiveWriter& writer;
+   unsigned long long skipped;
+   unsigned long long moves;
+   GameArchiver (GameArchiveWriter& w): writer(w), skipped(0), moves(0) {}
+   void gameFinished (Game const& game, bool ok) {
+      if (!ok || !writer.add(game))
+         ++skipped;
+      else
+         moves += game.plies();
+   }
+};
+
+//------------------------------------------------------------------------------
+// compress <pgn file> <archive>: stores the games' main lines as move indices.
+int compressGames (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s compress <pgn file> <archive>\n", argv[0]);
+      return 1;
+   }
+   MappedFile in;
+   GameArchiveWriter out;
+   if (!in.open(argv[2]) || !out.open(argv[3])) {
+      fprintf(stderr, "can't open %s or %s\n", argv[2], argv[3]);
+      return 1;
+   }
+   GameArchiver archiver(out);
+   PgnReader reader;
+   reader.setObserver(&archiver);
+   reader.read(in.begin(), in.end());
+   unsigned long long games = out.games();
+   unsigned long long bytes = out.bytes();
+   if (!out.close()) {
+      fprintf(stderr, "can't write %s\n", argv[3]);
+      return 1;
+   }
+   printf("games %llu (skipped %llu) moves %llu: %llu PGN bytes -> %llu bytes (%.2f bits/move)\n",
+          games, archiver.skipped, archiver.moves,
+          static_cast<unsigned long long>(in.size()), bytes,
+          archiver.moves ? 8.0 * bytes / archiver.moves : 0.0);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// decode <archive> [threads]: rebuilds every position and reports throughput.
+int decodeGames (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s decode <archive> [threads]\n", argv[0]);
+      return 1;
+   }
+   unsigned threads = argc > 3 ? atoi(argv[3]) : 1;
+   GameArchive archive;
+   if (!archive.open(argv[2])) {
+      fprintf(stderr, "%s is not a game archive\n", argv[2]);
+      return 1;
+   }
+   long long start = millisecondsNow();
+   PgnStats stats = archive.replay(threads);
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   if (seconds <= 0)
+      seconds = 0.001;
+   printf("games %llu moves %llu errors %llu in %.3f s\n",
+          stats.games, stats.moves, stats.errors, seconds);
+   printf("ending in checkmate %llu, stalemate %llu\n", stats.checkmates, stats.stalemates);
+   printf("%.0f games/s, %.0f moves/s\n", stats.games / seconds, stats.moves / seconds);
+   return stats.errors ? 2 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Adds the opening moves of every game it's shown to a book, weighted by how
+// the game went for the side that played them (2 for a win, 1 for a draw or
+// an unknown result, 0 for a loss).
+class BookMaker: public PgnObserver {
+public:
+   BookWriter& writer;
+   unsigned plies;
+   int result;   // 1 light won, -1 dark won, 0 otherwise
+   BookMaker (BookWriter& w, unsigned p): writer(w), plies(p), result(0) {}
+   void tag (char const* name, unsigned nameLength, char const* value, unsigned valueLength) {
+      if (nameLength == 6 && strncmp(name, "Result", 6) == 0) {
+         std::string r(value, valueLength);
+         result = r == "1-0" ? 1 : r == "0-1" ? -1 : 0;
+      }
+   }
+   void gameFinished (Game const& game, bool ok) {
+      for (unsigned ply=0; ok && ply<game.plies() && ply<plies; ++ply) {
+         Board const& b = game.board(ply);
+         int sign = b.pathDependence().lightMove() ? 1 : -1;
+         writer.add(b, game.moveAt(ply), 1 + sign * result);
+      }
+      result = 0;
+   }
+};
+
+//------------------------------------------------------------------------------
+// book <pgn file> <book> [plies]: writes a Polyglot book of the games' first
+// moves (20 plies by default).
+int makeBook (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s book <pgn file> <book> [plies]\n", argv[0]);
+      return 1;
+   }
+   MappedFile in;
+   if (!in.open(argv[2])) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+   BookWriter writer;
+   BookMaker maker(writer, argc > 4 ? atoi(argv[4]) : 20);
+   PgnReader reader;
+   reader.setObserver(&maker);
+   reader.read(in.begin(), in.end());
+   long long entries = writer.write(argv[3]);
+   if (entries < 0) {
+      fprintf(stderr, "can't write %s\n", argv[3]);
+      return 1;
+   }
+   printf("games %llu -> %lld book entries\n", reader.stats().games, entries);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// tbgen <directory> [threads]: generates the endgame tables into a directory.
+int generateTablebases (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s tbgen <directory> [threads]\n", argv[0]);
+      return 1;
+   }
+   if (!Tablebases::generate(argv[2], argc > 3 ? atoi(argv[3]) : 1, true)) {
+      fprintf(stderr, "can't write tables to %s\n", argv[2]);
+      return 1;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// tbprobe <directory> <fen>: looks a position up in the endgame tables.
+int probeTablebases (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s tbprobe <directory> <fen>\n", argv[0]);
+      return 1;
+   }
+   Tablebases tables;
+   if (tables.load(argv[2]) == 0) {
+      fprintf(stderr, "no tables in %s\n", argv[2]);
+      return 1;
+   }
+   Board b;
+   if (!Fen::read(argv[3], b)) {
+      fprintf(stderr, "bad FEN %s\n", argv[3]);
+      return 1;
+   }
+   unsigned result, distance;
+   if (!tables.probe(b, result, distance)) {
+      printf("not in the tables\n");
+      return 0;
+   }
+   if (result == TB::draw)
+      printf("draw\n");
+   else
+      printf("%s in %u plies\n", result == TB::win ? "win" : "loss", distance);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// tree <pgn file> <index> [threads] [plies] [megabytes]: counts the moves of the
+// games' first plies (30 by default) and how they scored, in a sorted index.
+// Past the memory budget (1024 MB by default) the counts spill to disk.
+int buildTree (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s tree <pgn file> <index> [threads] [plies] [megabytes]\n", argv[0]);
+      return 1;
+   }
+   MappedFile in;
+   if (!in.open(argv[2])) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+   unsigned threads = argc > 4 ? atoi(argv[4]) : 1;
+   unsigned plies = argc > 5 ? atoi(argv[5]) : 30;
+   unsigned long long megabytes = argc > 6 ? atoi(argv[6]) : 1024;
+   if (threads == 0)
+      threads = 1;
+
+   long long start = millisecondsNow();
+   OpeningTreeBuilder builder(argv[3], megabytes << 20);
+   std::vector<PgnObserver*> collectors;
+   for (unsigned i=0; i<threads; ++i)
+      collectors.push_back(new TreeCollector(builder, plies));
+   PgnStats stats = Pgn::replay(in.begin(), in.end(), threads, &collectors[0]);
+   // collectors hand over what they still hold when they go
+   for (unsigned i=0; i<threads; ++i)
+      delete collectors[i];
+   unsigned runs = builder.runs();
+   long long records = builder.write();
+   if (records < 0) {
+      fprintf(stderr, "can't write %s\n", argv[3]);
+      return 1;
+   }
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   printf("games %llu moves %llu errors %llu -> %lld records (%u runs) in %.3f s\n",
+          stats.games, stats.moves, stats.errors, records, runs, seconds);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// treequery <index> [fen]: lists the recorded moves of a position (the
+// starting position by default) and how they scored for the side playing them.
+int queryTree (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s treequery <index> [fen]\n", argv[0]);
+      return 1;
+   }
+   OpeningTree tree;
+   if (!tree.open(argv[2])) {
+      fprintf(stderr, "%s is not a tree index\n", argv[2]);
+      return 1;
+   }
+   Board b;
+   if (!Fen::read(argc > 3 ? argv[3] : Fen::startPosition, b)) {
+      fprintf(stderr, "bad FEN %s\n", argv[3]);
+      return 1;
+   }
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   TreeRecord const* first;
+   unsigned n = tree.find(b, first);
+   double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+   bool light = b.pathDependence().lightMove();
+   unsigned long long games = 0;
+   for (unsigned i=0; i<n; ++i) {
+      TreeRecord const& r = first[i];
+      games += r.games;
+      char text[8];
+      *Move::unpack(r.move).writeCoordinates(text) = 0;
+      unsigned wins = light ? r.lightWins : r.darkWins;
+      unsigned losses = light ? r.darkWins : r.lightWins;
+      unsigned decided = wins + r.draws + losses;
+      printf("%-6s %8u games  +%u =%u -%u  %5.1f%%  first at ply %u\n", text, r.games,
+             wins, r.draws, losses, decided ? 100.0 * (wins + 0.5 * r.draws) / decided : 0.0,
+             r.firstPly);
+   }
+   printf("%llu games, %u moves, found in %.1f us\n", games, n, micros);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// compactcache <cache>: rewrites an analysis cache with one record per position.
+int compactCache (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s compactcache <cache>\n", argv[0]);
+      return 1;
+   }
+   AnalysisCache cache;
+   if (!cache.open(argv[2])) {
+      fprintf(stderr, "%s is not an analysis cache\n", argv[2]);
+      return 1;
+   }
+   long long kept = cache.compact();
+   if (kept < 0) {
+      fprintf(stderr, "can't compact %s\n", argv[2]);
+      return 1;
+   }
+   printf("kept %lld positions, dropped %llu bytes of torn records\n", kept, cache.discarded());
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// Shows every position of the games it's shown on the terminal, pausing after
+// each move, and counts the bytes that took.
+class GameWatcher: public PgnObserver {
+public:
+   AsciiTerminal terminal;
+   unsigned milliseconds;
+   unsigned long long moves;
+   unsigned long long bytes;
+   GameWatcher (unsigned ms): terminal(1), milliseconds(ms), moves(0), bytes(0) {}
+   void gameStarted (Board const& start) { show(start); }
+   void movePlayed (Game const& game, Move const& move) {
+      show(game.currentBoard());
+      ++moves;
+   }
+   void show (Board const& b) {
+      terminal.show(b.bitboard());
+      bytes += terminal.written();
+      std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+   }
+};
+
+//------------------------------------------------------------------------------
+// watch <pgn file> [milliseconds]: plays the games out on the terminal,
+// redrawing only the squares each move changes (250 ms per move by default).
+int watchGames (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s watch <pgn file> [milliseconds]\n", argv[0]);
+      return 1;
+   }
+   MappedFile in;
+   if (!in.open(argv[2])) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+   GameWatcher watcher(argc > 3 ? atoi(argv[3]) : 250);
+   PgnReader reader;
+   reader.setObserver(&watcher);
+   reader.read(in.begin(), in.end());
+   fprintf(stderr, "moves %llu, %llu bytes drawn (%.0f per move)\n", watcher.moves,
+           watcher.bytes, watcher.moves ? static_cast<double>(watcher.bytes) / watcher.moves : 0.0);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// perft <depth> [fen] [megabytes]: counts the leaves of the legal move tree of
+// a position (the starting position by default), caching subtree counts in a
+// table of the given size if one is given.
+int countPerft (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s perft <depth> [fen] [megabytes]\n", argv[0]);
+      return 1;
+   }
+   unsigned depth = atoi(argv[2]);
+   unsigned megabytes = argc > 4 ? atoi(argv[4]) : 0;
+   Board b;
+   if (!Fen::read(argc > 3 ? argv[3] : Fen::startPosition, b)) {
+      fprintf(stderr, "bad FEN %s\n", argv[3]);
+      return 1;
+   }
+
+   PerftTable* table = megabytes ? new PerftTable(megabytes) : 0;
+   long long start = millisecondsNow();
+   unsigned long long nodes = Perft::count(b, depth, table);
+   long long elapsed = millisecondsNow() - start;
+   delete table;
+   if (elapsed <= 0)
+      elapsed = 1;
+   printf("perft %u: %llu\n", depth, nodes);
+   printf("time %lld ms, %llu leaves/s\n", elapsed, nodes * 1000 / elapsed);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// divide <depth> [fen] [megabytes]: perft split by first move, for finding
+// where a count goes wrong.
+int dividePerft (int argc, char** argv) {
+   if (argc < 3 || atoi(argv[2]) < 1) {
+      fprintf(stderr, "usage: %s divide <depth> [fen] [megabytes]\n", argv[0]);
+      return 1;
+   }
+   unsigned depth = atoi(argv[2]);
+   unsigned megabytes = argc > 4 ? atoi(argv[4]) : 0;
+   Board b;
+   if (!Fen::read(argc > 3 ? argv[3] : Fen::startPosition, b)) {
+      fprintf(stderr, "bad FEN %s\n", argv[3]);
+      return 1;
+   }
+
+   PerftTable* table = megabytes ? new PerftTable(megabytes) : 0;
+   MoveList moves;
+   std::vector<unsigned long long> counts(MoveList::capacity);
+   unsigned long long nodes = Perft::divide(b, depth, moves, &counts[0], table);
+   delete table;
+   for (unsigned i=0; i<moves.size; ++i) {
+      char text[8];
+      *moves[i].writeCoordinates(text) = 0;
+      printf("%s: %llu\n", text, counts[i]);
+   }
+   printf("moves %u leaves %llu\n", moves.size, nodes);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// One line of a perft suite: a position and its known counts.
+struct PerftEntry {
+   Board board;
+   unsigned line;
+   // expected[i] is the count at depths[i], deepening
+   std::vector<unsigned> depths;
+   std::vector<unsigned long long> expected;
+   // the first depth whose count was wrong (or 0), what it counted and should have
+   unsigned failedDepth;
+   unsigned long long got;
+   unsigned long long want;
+   unsigned long long leaves;
+   long long microseconds;
+};
+
+//------------------------------------------------------------------------------
+// Reads lines like "<fen> ;D1 20 ;D2 400" (a line may skip depths). Returns
+// false if a line is bad.
+bool readPerftSuite (char const* begin, char const* end, std::vector<PerftEntry>& entries) {
+   unsigned line = 0;
+   for (char const* p = begin; p < end; ) {
+      char const* lineEnd = static_cast<char const*>(memchr(p, '\n', end - p));
+      if (!lineEnd)
+         lineEnd = end;
+      ++line;
+      char const* fenEnd = static_cast<char const*>(memchr(p, ';', lineEnd - p));
+      if (lineEnd > p && *p != '#' && *p != '\r') {
+         PerftEntry entry;
+         entry.line = line;
+         entry.failedDepth = 0;
+         entry.got = 0;
+         entry.want = 0;
+         entry.leaves = 0;
+         entry.microseconds = 0;
+         if (!fenEnd || !Fen::read(p, fenEnd, entry.board)) {
+            fprintf(stderr, "line %u: bad position\n", line);
+            return false;
+         }
+         for (char const* q = fenEnd; q < lineEnd; ) {
+            char* next;
+            ++q;
+            while (q < lineEnd && *q == ' ')
+               ++q;
+            unsigned depth = q < lineEnd && *q == 'D' ? strtoul(q + 1, &next, 10) : 0;
+            if (depth == 0 || (!entry.depths.empty() && depth <= entry.depths.back())) {
+               fprintf(stderr, "line %u: expected a deeper D<depth> <count>\n", line);
+               return false;
+            }
+            entry.depths.push_back(depth);
+            entry.expected.push_back(strtoull(next, &next, 10));
+            q = static_cast<char const*>(memchr(next, ';', lineEnd - next));
+            if (!q)
+               q = lineEnd;
+         }
+         entries.push_back(entry);
+      }
+      p = lineEnd + 1;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Runs entries until none are left, each up to maxDepth or its first wrong count.
+void runPerftEntries (std::vector<PerftEntry>* entries, std::atomic<unsigned>* next,
+                      unsigned maxDepth, PerftTable* table) {
+   for (unsigned i = (*next)++; i < entries->size(); i = (*next)++) {
+      PerftEntry& e = (*entries)[i];
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (unsigned i=0; i<e.depths.size() && e.depths[i]<=maxDepth; ++i) {
+         unsigned long long n = Perft::count(e.board, e.depths[i], table);
+         e.leaves += n;
+         if (n != e.expected[i]) {
+            e.failedDepth = e.depths[i];
+            e.got = n;
+            e.want = e.expected[i];
+            break;
+         }
+      }
+      e.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - start).count();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Explains a wrong count: either generateLegalMoves disagrees with the brute
+// force reference somewhere below, or the two agree and the move rules
+// themselves are off, in which case the divide is shown for comparison with
+// another program's.
+void explainPerftFailure (PerftEntry const& e) {
+   MoveList path, missing, extra;
+   char text[8];
+   if (Perft::findDivergence(e.board, e.failedDepth, path, missing, extra)) {
+      printf("   differs from the reference after:");
+      for (unsigned i=0; i<path.size; ++i) {
+         *path[i].writeCoordinates(text) = 0;
+         printf(" %s", text);
+      }
+      printf(path.size ? "\n" : " (the root)\n");
+      for (unsigned i=0; i<missing.size; ++i) {
+         *missing[i].writeCoordinates(text) = 0;
+         printf("   missing %s\n", text);
+      }
+      for (unsigned i=0; i<extra.size; ++i) {
+         *extra[i].writeCoordinates(text) = 0;
+         printf("   extra %s\n", text);
+      }
+      return;
+   }
+
+   printf("   the reference agrees, so the move rules are at fault; divide %u:\n", e.failedDepth);
+   MoveList moves;
+   std::vector<unsigned long long> counts(MoveList::capacity);
+   Perft::divide(e.board, e.failedDepth, moves, &counts[0]);
+   for (unsigned i=0; i<moves.size; ++i) {
+      *moves[i].writeCoordinates(text) = 0;
+      printf("   %s: %llu\n", text, counts[i]);
+   }
+}
+
+//------------------------------------------------------------------------------
+// perftsuite <epd file> [max depth] [threads] [megabytes]: checks the move
+// generator against a suite of positions with known perft counts, running
+// entries in parallel (sharing one perft table if megabytes is given). Each
+// wrong count is traced down to the first move that goes wrong.
+int runPerftSuite (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s perftsuite <epd file> [max depth] [threads] [megabytes]\n",
+              argv[0]);
+      return 1;
+   }
+   unsigned maxDepth = argc > 3 ? atoi(argv[3]) : 0;
+   unsigned threads = argc > 4 ? atoi(argv[4]) : std::thread::hardware_concurrency();
+   unsigned megabytes = argc > 5 ? atoi(argv[5]) : 0;
+   if (maxDepth == 0)
+      maxDepth = ~0u;
+   if (threads == 0)
+      threads = 1;
+   MappedFile in;
+   if (!in.open(argv[2])) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+   std::vector<PerftEntry> entries;
+   if (!readPerftSuite(in.begin(), in.end(), entries))
+      return 1;
+
+   PerftTable* table = megabytes ? new PerftTable(megabytes) : 0;
+   long long start = millisecondsNow();
+   std::atomic<unsigned> next(0);
+   std::vector<std::thread> workers;
+   for (unsigned i=1; i<threads; ++i)
+      workers.push_back(std::thread(runPerftEntries, &entries, &next, maxDepth, table));
+   runPerftEntries(&entries, &next, maxDepth, table);
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+   long long elapsed = millisecondsNow() - start;
+   delete table;
+   if (elapsed <= 0)
+      elapsed = 1;
+
+   unsigned failed = 0;
+   unsigned skipped = 0;
+   unsigned long long leaves = 0;
+   for (unsigned i=0; i<entries.size(); ++i) {
+      PerftEntry const& e = entries[i];
+      leaves += e.leaves;
+      unsigned depth = 0;
+      for (unsigned j=0; j<e.depths.size() && e.depths[j]<=maxDepth; ++j)
+         depth = e.depths[j];
+      if (depth == 0) {
+         printf("line %u: skipped, no count within the depth limit\n", e.line);
+         ++skipped;
+         continue;
+      }
+      if (!e.failedDepth) {
+         printf("line %u: ok to depth %u, %llu leaves, %lld ms\n", e.line, depth, e.leaves,
+                e.microseconds / 1000);
+         continue;
+      }
+      ++failed;
+      printf("line %u: depth %u counts %llu, expected %llu\n", e.line, e.failedDepth, e.got,
+             e.want);
+      explainPerftFailure(e);
+   }
+   printf("entries %u passed %u failed %u skipped %u\n", static_cast<unsigned>(entries.size()),
+          static_cast<unsigned>(entries.size()) - failed - skipped, failed, skipped);
+   printf("leaves %llu in %lld ms (%llu leaves/s, %u threads)\n", leaves, elapsed,
+          leaves * 1000 / elapsed, threads);
+   return failed ? 2 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Reads a player given as "default" or as UCI options, ex "NullMove=false,Hash=32".
+bool readPlayer (char const* spec, SelfPlayPlayer& player) {
+   player = SelfPlayPlayer();
+   player.name = spec;
+   if (strcmp(spec, "default") == 0)
+      return true;
+   std::string text(spec);
+   for (size_t start = 0; start < text.size(); ) {
+      size_t end = text.find(',', start);
+      if (end == std::string::npos)
+         end = text.size();
+      std::string option = text.substr(start, end - start);
+      size_t equals = option.find('=');
+      if (equals == std::string::npos)
+         return false;
+      std::string name = option.substr(0, equals);
+      std::string value = option.substr(equals + 1);
+      bool on = value == "true";
+      if (name == "Hash")
+         player.hash = atoi(value.c_str());
+      else if (name == "NullMove")
+         player.options.nullMove = on;
+      else if (name == "LateMoveReductions")
+         player.options.lateMoveReductions = on;
+      else if (name == "Futility")
+         player.options.futility = on;
+      else if (name == "ReverseFutility")
+         player.options.reverseFutility = on;
+      else if (name == "CheckExtensions")
+         player.options.checkExtensions = on;
+      else
+         return false;
+      start = end + 1;
+   }
+   return true;
+}
+
+//------------------------------------------------------------------------------
+// Prints a line of progress as each game finishes.
+class SelfPlayProgress: public SelfPlayObserver {
+public:
+   long long start;
+   unsigned games;
+   SelfPlayProgress (unsigned g): start(millisecondsNow()), games(g) {}
+   void gameFinished (SelfPlayGame const& game, Sprt const& sprt) {
+      double minutes = (millisecondsNow() - start) / 60000.0;
+      fprintf(stderr, "game %u/%u (opening %u, first player %s): %s by %s in %u plies | "
+              "+%llu =%llu -%llu, elo %.1f +- %.1f, LLR %.2f [%.2f, %.2f], %.1f games/min\n",
+              game.index + 1, games, game.opening + 1, game.firstIsLight ? "light" : "dark",
+              game.result > 0 ? "won" : game.result < 0 ? "lost" : "drawn", game.reason,
+              game.plies, sprt.wins(), sprt.draws(), sprt.losses(), sprt.elo(), sprt.eloMargin(),
+              sprt.llr(), sprt.lowerBound(), sprt.upperBound(),
+              minutes > 0 ? sprt.games() / minutes : 0.0);
+   }
+};
+
+//------------------------------------------------------------------------------
+// selfplay <first> <second> [games] [threads] [control] [openings] [elo0] [elo1]:
+// plays the first player against the second, many games at once, until the
+// SPRT of elo0 against elo1 decides or the games run out. Players are
+// "default" or UCI options (see readPlayer); the control is nodes per move
+// (ex, 20000) or milliseconds (ex, 100ms); openings is a FEN or EPD file
+// whose positions are each played twice, once with each colour. With fewer
+// distinct openings than pairs of games, each pair starts with 8 random plies.
+int playSelf (int argc, char** argv) {
+   if (argc < 4) {
+      fprintf(stderr, "usage: %s selfplay <first> <second> [games] [threads] [control] "
+              "[openings] [elo0] [elo1]\n", argv[0]);
+      return 1;
+   }
+   SelfPlayPlayer players[2];
+   for (unsigned i=0; i<2; ++i) {
+      if (!readPlayer(argv[2 + i], players[i])) {
+         fprintf(stderr, "bad player %s\n", argv[2 + i]);
+         return 1;
+      }
+   }
+   unsigned games = argc > 4 ? atoi(argv[4]) : 1000;
+   unsigned threads = argc > 5 ? atoi(argv[5]) : std::thread::hardware_concurrency();
+   SelfPlaySettings settings;
+   if (argc > 6) {
+      char* end;
+      long long n = strtoll(argv[6], &end, 10);
+      settings.nodes = strcmp(end, "ms") == 0 ? 0 : n;
+      settings.moveTime = strcmp(end, "ms") == 0 ? n : 0;
+   }
+   double elo0 = argc > 8 ? atof(argv[8]) : 0;
+   double elo1 = argc > 9 ? atof(argv[9]) : 5;
+   if (threads == 0)
+      threads = 1;
+
+   // repeated openings are dropped: under a node limit both searchers are
+   // deterministic, so a repeated pair of games would count twice
+   std::vector<Board> openings;
+   if (argc > 7) {
+      MappedFile in;
+      if (!in.open(argv[7])) {
+         fprintf(stderr, "can't open %s\n", argv[7]);
+         return 1;
+      }
+      std::set<std::string> seen;
+      for (char const* p = in.begin(); p < in.end(); ) {
+         char const* end = static_cast<char const*>(memchr(p, '\n', in.end() - p));
+         if (!end)
+            end = in.end();
+         Board b;
+         char const* operations;
+         if (end > p && *p != '#' && (Fen::read(p, end, b) || Fen::readEpd(p, end, b, operations))) {
+            char fen[Fen::maxLength];
+            if (seen.insert(std::string(fen, Fen::write(b, fen))).second)
+               openings.push_back(b);
+         }
+         p = end + 1;
+      }
+   }
+   if (openings.empty()) {
+      Board b;
+      Fen::read(Fen::startPosition, b);
+      openings.push_back(b);
+   }
+   // each opening is played twice, once with each colour; without one per
+   // pair, random moves keep the pairs apart
+   if (openings.size() < (games + 1) / 2)
+      settings.randomPlies = 8;
+
+   SelfPlay match(players[0], players[1], settings, openings);
+   SelfPlayProgress progress(games);
+   match.setObserver(&progress);
+   long long start = millisecondsNow();
+   Sprt sprt = match.run(games, threads, Sprt(elo0, elo1));
+   double minutes = (millisecondsNow() - start) / 60000.0;
+   if (minutes <= 0)
+      minutes = 1e-6;
+
+   printf("%s vs %s: %llu games from %u openings (%u random plies), %u threads\n",
+          players[0].name.c_str(), players[1].name.c_str(), sprt.games(),
+          static_cast<unsigned>(openings.size()), settings.randomPlies, threads);
+   printf("+%llu =%llu -%llu, elo %.1f +- %.1f\n", sprt.wins(), sprt.draws(), sprt.losses(),
+          sprt.elo(), sprt.eloMargin());
+   printf("SPRT elo0 %.1f elo1 %.1f: LLR %.2f [%.2f, %.2f] %s\n", elo0, elo1, sprt.llr(),
+          sprt.lowerBound(), sprt.upperBound(),
+          sprt.decision() > 0 ? "H1 accepted" : sprt.decision() < 0 ? "H0 accepted" : "undecided");
+   printf("%.1f games/min\n", sprt.games() / minutes);
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// analyze [file] [threads] [control] [megabytes]: searches every FEN or EPD
+// line of a file (or of stdin, if the file is "-" or missing) and writes a
+// bestmove and score line for each, in input order. The control is a depth
+// (ex, d8), milliseconds (ex, 100ms) or nodes (ex, 100000) per position.
+int analyzeBatch (int argc, char** argv) {
+   unsigned threads = argc > 3 ? atoi(argv[3]) : std::thread::hardware_concurrency();
+   unsigned megabytes = argc > 5 ? atoi(argv[5]) : 64;
+   SearchLimits limits;
+   limits.nodes = 100000;
+   if (argc > 4) {
+      char* end;
+      if (argv[4][0] == 'd') {
+         limits.nodes = 0;
+         limits.depth = strtoul(argv[4] + 1, &end, 10);
+      } else {
+         long long n = strtoll(argv[4], &end, 10);
+         limits.nodes = strcmp(end, "ms") == 0 ? 0 : n;
+         limits.moveTime = strcmp(end, "ms") == 0 ? n : 0;
+      }
+      if (*end && strcmp(end, "ms") != 0) {
+         fprintf(stderr, "usage: %s analyze [file] [threads] [d<depth> | <ms>ms | <nodes>] "
+                 "[megabytes]\n", argv[0]);
+         return 1;
+      }
+   }
+   if (threads == 0)
+      threads = 1;
+   int fd = argc < 3 || strcmp(argv[2], "-") == 0 ? 0 : open(argv[2], O_RDONLY);
+   if (fd < 0) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+
+   AsyncWriter out(1);
+   BatchAnalysis batch(threads, megabytes, limits);
+   long long start = millisecondsNow();
+   bool ok = batch.run(fd, out);
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   if (seconds <= 0)
+      seconds = 0.001;
+   fprintf(stderr, "positions %llu in %.3f s (%.1f positions/s, %u threads)\n",
+           batch.positions(), seconds, batch.positions() / seconds, threads);
+   if (!ok) {
+      fprintf(stderr, "read error\n");
+      return 1;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+// One line of a mate batch, and what the solver made of it.
+struct MatePuzzle {
+   Board board;
+   unsigned line;
+   unsigned moves;     // mate in at most this many
+   bool claimed;       // moves came from a dm operation, which should hold exactly
+   MateSolver::Result result;
+   long long microseconds;
+};
+
+//------------------------------------------------------------------------------
+// Solves puzzles until none are left. The table stays warm from one puzzle to
+// the next: proofs hold for any puzzle that reaches the same position.
+void solveMates (std::vector<MatePuzzle>* puzzles, std::atomic<unsigned>* next,
+                 unsigned long long nodeLimit) {
+   MateSolver solver(64);
+   solver.setNodeLimit(nodeLimit);
+   for (unsigned i = (*next)++; i < puzzles->size(); i = (*next)++) {
+      MatePuzzle& p = (*puzzles)[i];
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      p.result = solver.solve(p.board, p.moves);
+      p.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - start).count();
+   }
+}
+
+//------------------------------------------------------------------------------
+// mate <epd file> [moves] [threads] [node limit]: proves the shortest mate of
+// each position in at most its "dm" operation's moves (or moves, 3 by default)
+// and reports the solve time of each. A dm claim holds only if the shortest
+// mate is exactly that long. Positions are solved on several threads and
+// reported in file order.
+int solveMatePuzzles (int argc, char** argv) {
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s mate <epd file> [moves] [threads] [node limit]\n", argv[0]);
+      return 1;
+   }
+   unsigned moves = argc > 3 ? atoi(argv[3]) : 3;
+   unsigned threads = argc > 4 ? atoi(argv[4]) : 1;
+   unsigned long long nodeLimit = argc > 5 ? strtoull(argv[5], 0, 10) : 1000000;
+   if (threads == 0)
+      threads = 1;
+   MappedFile in;
+   if (!in.open(argv[2])) {
+      fprintf(stderr, "can't open %s\n", argv[2]);
+      return 1;
+   }
+
+   std::vector<MatePuzzle> puzzles;
+   unsigned line = 0;
+   for (char const* p = in.begin(); p < in.end(); ) {
+      char const* end = static_cast<char const*>(memchr(p, '\n', in.end() - p));
+      if (!end)
+         end = in.end();
+      ++line;
+      if (end > p && *p != '#' && *p != '\r') {
+         MatePuzzle puzzle;
+         char const* operations;
+         char const* value;
+         unsigned length;
+         if (!Fen::readEpd(p, end, puzzle.board, operations)) {
+            fprintf(stderr, "line %u: bad position\n", line);
+         } else {
+            puzzle.line = line;
+            puzzle.moves = moves;
+            puzzle.claimed = Fen::findOperation(operations, end, "dm", value, length);
+            if (puzzle.claimed)
+               puzzle.moves = atoi(std::string(value, length).c_str());
+            puzzles.push_back(puzzle);
+         }
+      }
+      p = end + 1;
+   }
+
+   long long start = millisecondsNow();
+   std::atomic<unsigned> next(0);
+   std::vector<std::thread> workers;
+   for (unsigned i=1; i<threads; ++i)
+      workers.push_back(std::thread(solveMates, &puzzles, &next, nodeLimit));
+   solveMates(&puzzles, &next, nodeLimit);
+   for (unsigned i=0; i<workers.size(); ++i)
+      workers[i].join();
+   double seconds = (millisecondsNow() - start) / 1000.0;
+   if (seconds <= 0)
+      seconds = 0.001;
+
+   unsigned mates = 0;
+   unsigned wrong = 0;
+   unsigned unknown = 0;
+   for (unsigned i=0; i<puzzles.size(); ++i) {
+      MatePuzzle const& p = puzzles[i];
+      MateSolver::Result const& r = p.result;
+      char move[8] = "";
+      if (r.move.valid())
+         *r.move.writeCoordinates(move) = 0;
+      char const* verdict = "";
+      if (!r.complete && !r.moves) {
+         verdict = "  (node limit)";
+         ++unknown;
+      } else if (p.claimed && r.moves != p.moves) {
+         verdict = "  (claim fails)";
+         ++wrong;
+      }
+      mates += r.moves != 0;
+      if (r.moves)
+         printf("line %u: mate in %u %s, %llu nodes, %lld us%s\n", p.line, r.moves, move,
+                r.nodes, p.microseconds, verdict);
+      else
+         printf("line %u: no mate in %u, %llu nodes, %lld us%s\n", p.line, p.moves,
+                r.nodes, p.microseconds, verdict);
+   }
+   printf("puzzles %u mates %u failed claims %u unsolved %u in %.3f s (%.0f puzzles/s)\n",
+          static_cast<unsigned>(puzzles.size()), mates, wrong, unknown, seconds,
+          puzzles.size() / seconds);
+   return wrong || unknown ? 2 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Openings, middlegames and endgames, including positions with castling and en
+// passant available, promotions pending, and no moves at all.
+char const* const benchPositions[] = {
+   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+   "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+   "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+   "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+   "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+   "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+   "rnbqkb1r/1p2pppp/p2p1n2/8/3NP3/2N5/PPP2PPP/R1BQKB1R w KQkq - 0 6",
+   "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+   "rnbqkb1r/ppp2ppp/4pn2/3p4/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4",
+   "rnbq1rk1/ppp1ppbp/3p1np1/8/2PPP3/2N2N2/PP3PPP/R1BQKB1R w KQ - 1 6",
+   "rnbqkbnr/ppp2ppp/4p3/3pP3/3P4/8/PPP2PPP/RNBQKBNR b KQkq - 0 3",
+   "rnbqkbnr/pp2pppp/2p5/3pP3/3P4/8/PPP2PPP/RNBQKBNR b KQkq - 0 3",
+   "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+   "r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2Q1RK1 w - - 0 10",
+   "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+   "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+   "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+   "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+   "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+   "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+   "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+   "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+   "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+   "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+   "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+   "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+   "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+   "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+   "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+   "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+   "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+   "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+   "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+   "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+   "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+   "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+   "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+   "8/5pk1/6p1/8/8/6P1/5PK1/8 w - - 0 1",
+   "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+   "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1",
+   "8/8/8/3k4/8/8/2Q5/4K3 w - - 0 1",
+   "6k1/5p2/6p1/8/7P/6P1/r4PK1/R7 w - - 0 1",
+   "8/4kp2/8/3K4/8/8/5P2/8 w - - 0 1",
+   "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2",
+   "8/8/8/8/8/8/6k1/4K2R w K - 0 1",
+   "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+   "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+   "7k/6Q1/6K1/8/8/8/8/8 b - - 0 1"
+};
+
+//------------------------------------------------------------------------------
+// bench [depth] [threads] [hash megabytes]: searches a fixed set of positions
+// to a fixed depth (6, 1 thread and 16 MB by default), each from a cleared
+// table. The node total is a signature of the search: on one thread it
+// changes only when the search itself does, so it must survive any pure
+// speedup. More threads share the table nondeterministically.
+int benchSearch (int argc, char** argv) {
+   unsigned depth = argc > 2 ? atoi(argv[2]) : 6;
+   unsigned threads = argc > 3 ? atoi(argv[3]) : 1;
+   unsigned hash = argc > 4 ? atoi(argv[4]) : 16;
+   if (depth == 0 || threads == 0 || hash == 0) {
+      fprintf(stderr, "usage: %s bench [depth] [threads] [hash megabytes]\n", argv[0]);
+      return 1;
+   }
+
+   SearchPool pool;
+   pool.setThreads(threads);
+   pool.setHashSize(hash);
+   SearchLimits limits;
+   limits.depth = depth;
+
+   unsigned count = sizeof(benchPositions) / sizeof(benchPositions[0]);
+   unsigned long long nodes = 0;
+   long long elapsed = 0;
+   for (unsigned i=0; i<count; ++i) {
+      Board b;
+      if (!Fen::read(benchPositions[i], b)) {
+         fprintf(stderr, "bad bench position %s\n", benchPositions[i]);
+         return 1;
+      }
+      pool.clear();
+      long long start = millisecondsNow();
+      Move best = pool.search(b, limits);
+      elapsed += millisecondsNow() - start;
+      nodes += pool.nodes();
+
+      char move[8] = "none";
+      if (best.valid())
+         *best.writeCoordinates(move) = 0;
+      fprintf(stderr, "position %2u/%u: %-5s %10llu nodes\n", i + 1, count, move, pool.nodes());
    }
-   */
+   if (elapsed <= 0)
+      elapsed = 1;
+   printf("positions %u depth %u threads %u hash %u MB\n", count, depth, threads, hash);
+   printf("nodes %llu\n", nodes);
+   printf("time %lld ms\n", elapsed);
+   printf("nps %llu\n", nodes * 1000 / elapsed);
+   return 0;
+}
 
+//------------------------------------------------------------------------------
+// Runs the subcommand argv[1] names, or the UCI loop if it names none.
+int run (int argc, char** argv) {
+   if (argc > 1 && strcmp(argv[1], "pgn") == 0)
+      return replayPgn(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "pack") == 0)
+      return packPositions(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "scan") == 0)
+      return scanPositions(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "compress") == 0)
+      return compressGames(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "decode") == 0)
+      return decodeGames(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "book") == 0)
+      return makeBook(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "tbgen") == 0)
+      return generateTablebases(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "tbprobe") == 0)
+      return probeTablebases(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "tree") == 0)
+      return buildTree(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "treequery") == 0)
+      return queryTree(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "compactcache") == 0)
+      return compactCache(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "watch") == 0)
+      return watchGames(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "bench") == 0)
+      return benchSearch(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "mate") == 0)
+      return solveMatePuzzles(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "perft") == 0)
+      return countPerft(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "divide") == 0)
+      return dividePerft(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "perftsuite") == 0)
+      return runPerftSuite(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "selfplay") == 0)
+      return playSelf(argc, argv);
+   if (argc > 1 && strcmp(argv[1], "analyze") == 0)
+      return analyzeBatch(argc, argv);
+
+   GambitInterface gambit;
+   gambit.loop();
+   return 0;
 }
 
+//------------------------------------------------------------------------------
+// trace <file> [subcommand ...]: runs the subcommand (or the UCI loop) with
+// tracing on, then writes the timeline to file as Chrome trace JSON.
+int main (int argc, char** argv) {
+   if (argc > 2 && strcmp(argv[1], "trace") == 0) {
+      std::vector<char*> args(argv, argv + argc + 1);
+      args.erase(args.begin() + 1, args.begin() + 3);
+      Trace::nameThread("main");
+      Trace::start();
+      int result = run(argc - 2, &args[0]);
+      if (!Trace::write(argv[2])) {
+         fprintf(stderr, "can't write %s\n", argv[2]);
+         return 1;
+      }
+      return result;
+   }
+   return run(argc, argv);
+}